@@ -3,6 +3,8 @@
 
 #include "base.hpp"
 #include "model_base.hpp"
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 #include <Eigen/Core>
@@ -17,15 +19,75 @@ namespace TimeSeries
      ---------------------------------------------------------------------------------
      --------------------------------------------------------------------------------- */
     
+    /**
+     @author: agent
+     @param series: series to compute autocorrelations of
+     @param length: number of lags, not counting lag 0
+     @return: autocorrelations at lags 0, ..., length. Sums are
+     accumulated in accumulator_t<T> (double for float series) and the
+     result is returned in result_t<T>, so a float series stays float
+     end to end
+     */
+    template<typename T>
+    extern Vec<result_t<T>> ACF(const Vec<T>& series, size_t length);
+    
+    //partial autocorrelations at lags 1, ..., length via Durbin-Levinson
+    template<typename T>
+    extern Vec<result_t<T>> pACF(const Vec<T>& series, size_t length);
+    
+    /**
+     @author: agent
+     @param params: AR coefficients then MA coefficients
+     @param p: AR order
+     @param q: MA order
+     @param z: demeaned (and differenced) series
+     @param e: residuals, same length as z. e[0, first) is taken as given
+     and e[first, end) is filled in; lags before the start of z count as 0
+     @param first: index of the first residual to compute
+     @brief: runs the ARMA filter e_t = z_t - sum_i phi_i z_{t-i}
+     - sum_j theta_j e_{t-j}. With first = p and e zeroed this gives the
+     conditional-sum-of-squares residuals; with z and e holding the tail
+     of an earlier fit in their first entries it extends that fit to new
+     observations without touching the old ones
+     */
     template<typename T>
-    extern Vec<double> ACF(Vec<T> series, size_t length);
+    extern void ARMA_filter(const std::vector<T>& params,
+                            size_t p,
+                            size_t q,
+                            const Vec<T>& z,
+                            Vec<T>& e,
+                            size_t first);
     
+    /**
+     @author: agent
+     @param z: demeaned (and differenced) series
+     @param p: AR order
+     @param q: MA order
+     @param start: starting parameters (AR then MA); if absent or the
+     wrong size, AR terms start from an OLS fit on p lags and MA terms at 0
+     @param maxIter: maximum Gauss-Newton iterations
+     @param tol: stop once an iteration improves the sum of squares by
+     less than this fraction
+     @return: conditional-sum-of-squares estimates of the AR then MA
+     coefficients, found by damped Gauss-Newton in accumulator precision
+     */
     template<typename T>
-    extern Vec<double> pACF(Vec<T> series, size_t length);
+    extern std::vector<T> CSS_fit(const Vec<T>& z,
+                                  size_t p,
+                                  size_t q,
+                                  std::optional<std::vector<T>> start = std::nullopt,
+                                  size_t maxIter = 50,
+                                  double tol = 1e-10);
+    
     
     
     
     
+    //serialized model state and its cache, see model_cache.hpp
+    template<typename T>
+    struct ModelState;
+    
+    class ModelCache;
     
     /* ---------------------------------------------------------------------------------
      ---------------------------------------------------------------------------------
@@ -36,49 +98,99 @@ namespace TimeSeries
      param order is AR coefs then MA coefs, then external regressors' coefs.
      outs contains a pair of vectors of (p,d,q, num_exog) and (sp,sd,sq),
      (seasonal terms) and an Eigen::VectorXd of residuals
-     and a vector
+     and a vector. The first element of outs holds (mean, innovation
+     variance) of the differenced series. T is the precision of the
+     parameters and residuals, normally the series_type of the ts being
+     modeled
      */
-    using ARIMAOutput = ModelOutput<double,
-                                    std::vector<double>,
+    template<typename T = double>
+    using ARIMAOutput = ModelOutput<T,
+                                    std::vector<T>,
                                     std::pair<std::vector<size_t>, std::vector<size_t>>,
-                                    Vec<double>
+                                    Vec<T>
                                     >;
     
     template<typename ts_type = ts<double>>
-    class ARMA : protected Model<ARIMAOutput>
+    class ARMA : protected Model<ts_type, ARIMAOutput<result_t<typename ts_type::series_type>>>
     {
+    public:
+        
+        //parameters and residuals are stored in value_type
+        typedef result_t<typename ts_type::series_type> value_type;
+        
+        //likelihoods and other long sums are accumulated in acc_type
+        typedef accumulator_t<typename ts_type::series_type> acc_type;
+        
+        typedef ARIMAOutput<value_type> output_type;
         
     protected:
         
         std::vector<size_t> params;
         
-        //(p,0,q) order
+        //(p,d,q) order; the series is differenced d times before fitting
         std::vector<size_t> order {0,0,0};
         
         bool isFit = false;
         
+        //starting point for the optimizer in fit, set by warm_start
+        std::optional<std::vector<value_type>> start_params;
+        
+        //extends a cached fit over the observations added since, see fit(cache)
+        output_type update(const ModelState<value_type>& cached,
+                           const Vec<value_type>& values) const;
+        
     public:
         
         ARMA() {};
         
-        ARMA(ts_type& tseries) : series(tseries);
+        ARMA(ts_type& tseries);
         
         ARMA(const ts_type& series);
         
-        ARIMAOutput fit();
+        output_type fit();
         
-        ARIMAOutput fit(std::vector<size_t> fixedOrder);
+        output_type fit(std::vector<size_t> fixedOrder);
         
         //fit on a subset of the series
-        ARIMAOutput fit(size_t start_id,
+        output_type fit(size_t start_id,
                         size_t end_id) const;
         
-        //log likelihood
-        double logLik() const;
+        /**
+         @author: agent
+         @param cache: cache of previous fits
+         @param series_id: key of this series in cache
+         @param refit: if true, a series that only gained observations is
+         refit at the cached order, with the optimizer starting from the
+         cached parameters. If false it is only updated: the cached
+         parameters are kept and the filter is run over the new
+         observations alone
+         @return: the cached output if the series is unchanged since the
+         cached fit, the updated or refit output if the cached fit's data
+         is a prefix of the series, else a cold fit at the cached order
+         (or the model's order if nothing is cached). Residuals cover
+         the observations added since the cached fit when it is reused
+         or updated (none if the series is unchanged), and the whole
+         series when it is refit; fit(order) recomputes them all. The
+         result is written back to cache
+         */
+        output_type fit(const ModelCache& cache,
+                        const std::string& series_id,
+                        bool refit = false);
+        
+        /* state to persist in a ModelCache; the model must have been fit
+         with residuals for the whole series, e.g. by fit(order). fit(cache)
+         stores its own state */
+        ModelState<value_type> state() const;
+        
+        //takes order and starting parameters from a previous fit
+        void warm_start(const ModelState<value_type>& cached);
+        
+        //log likelihood, accumulated in acc_type
+        acc_type logLik() const;
         
         void summary() const;
         
-        std::vector<double> ARMA_params() const;
+        std::vector<value_type> ARMA_params() const;
         
         std::vector<size_t> ARIMA_order() const;
         
@@ -87,18 +199,18 @@ namespace TimeSeries
         
         void setOrder(vector<size_t> newOrder);
         
-        Vec<double> resids();
+        Vec<value_type> resids();
         
         template<typename T>
         T characteristic_poly(T x);
         
-        //returns a triple (p,0,q)
+        //returns a triple (p,d,q)
         std::vector<size_t>
         estimate_order(std::optional<std::vector<size_t>> maxOrders,
                       std::optional<std::vector<size_t>> fixedOrders)
         const;
         
-        ARIMAOutput
+        output_type
         forecast(size_t forecastLength,
                  std::optional<size_t> start_id) const;
         
@@ -124,11 +236,11 @@ namespace TimeSeries
     };
     
     template<
-            ts_type,
-            bool fractional_order = false,
-            bool is_seasonal = false
+            typename ts_type,
+            bool Fractional = false,
+            bool Seasonal = false
             >
-    class ARIMA : protected ARMA
+    class ARIMA : protected ARMA<ts_type>
     {
         
     protected:
@@ -143,7 +255,7 @@ namespace TimeSeries
         
         ARIMA(ts_type series);
         
-        ARIMA(ts_type series, bool fractional, bool seasonal);
+        ARIMA(ts_type series, bool _fractional, bool _seasonal);
         
         //T is a size_t or a double
         template<typename T>
@@ -153,13 +265,13 @@ namespace TimeSeries
     };
     
     template<typename ts_type>
-    using SARIMA = ARIMA<ts_type, false, true>
+    using SARIMA = ARIMA<ts_type, false, true>;
     
     template<typename ts_type>
-    using ARFIMA = ARIMA<ts_type, true, false>
+    using ARFIMA = ARIMA<ts_type, true, false>;
     
     template<typename ts_type>
-    using SARFIMA = ARIMA<ts_type, true, true>
+    using SARFIMA = ARIMA<ts_type, true, true>;
     
 }//end namespace TimeSeries
 
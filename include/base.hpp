@@ -12,9 +12,11 @@
 #endif
 
 #include <Eigen/Core>
+#include <optional>
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 #include "boost/date_time/gregorian/gregorian.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include <type_traits>
@@ -63,6 +65,13 @@ namespace TimeSeries
     }
     
     
+    //rolling-window and exponentially weighted statistics, see rolling.hpp
+    template<typename Series_t, typename DateTime_t>
+    class Rolling;
+    
+    template<typename Series_t, typename DateTime_t>
+    class EWM;
+    
     /**
      @author: Zane Jakobs
      @brief: General time series class that requires an arithmetic
@@ -81,7 +90,7 @@ namespace TimeSeries
 
     public:
         
-        typename iterator;
+        class iterator;
         
         typedef Series_t series_type;
         
@@ -101,9 +110,19 @@ namespace TimeSeries
         template<typename Con, typename T>
         ts(Con& _data, T& _times);
         
-        ts(ts<Series_t,DateTime_t>& other);
+        //ctor from data only, Con as above; the series has no time labels
+        template<typename Con,
+                 typename = std::enable_if_t<not std::is_same<std::decay_t<Con>,
+                                                              ts<Series_t, DateTime_t>>::value>>
+        explicit ts(Con& _data);
+        
+        ts(const ts<Series_t,DateTime_t>& other) = default;
+        
+        ts(ts<Series_t,DateTime_t>&& other) = default;
+        
+        ts<Series_t,DateTime_t>& operator=(const ts<Series_t,DateTime_t>& other) = default;
         
-        ts(ts<Series_t,DateTime_t>&& other);
+        ts<Series_t,DateTime_t>& operator=(ts<Series_t,DateTime_t>&& other) = default;
         
         Vec<Series_t> getData() const noexcept;
         
@@ -112,13 +131,13 @@ namespace TimeSeries
         iterator end() const;
 
         //returns an iterator to data.begin()
-        Vec<Series_t>::iterator dbegin() const;
+        typename Vec<Series_t>::iterator dbegin() const;
         
-        Vec<Series_t>::iterator dend() const;
+        typename Vec<Series_t>::iterator dend() const;
         
-        DateVec<DateTime_t>::iterator tbegin() const;
+        typename DateVec<DateTime_t>::iterator tbegin() const;
         
-        DateVec<DateTime_t>::iterator tend() const;
+        typename DateVec<DateTime_t>::iterator tend() const;
         
         //TODO: template this like the ctor
         void setData(Vec<Series_t>& newData);
@@ -161,6 +180,40 @@ namespace TimeSeries
         TimeSeries::ts<Series_t, DateTime_t>
         operator*(Series_t scale);
         
+        /**
+         @author: agent
+         @param window: number of observations in the window
+         @return: Rolling object from which rolling statistics
+         can be computed, see rolling.hpp
+         */
+        Rolling<Series_t, DateTime_t> rolling(size_t window) const;
+        
+        //several windows at once, computed in a single pass
+        Rolling<Series_t, DateTime_t>
+        rolling(std::vector<size_t> windows) const;
+        
+        /**
+         @author: agent
+         @param span: length of time covered by the window. Throws
+         MissingTimeLabelsError if *this has no time labels
+         @return: Rolling object over time-based windows
+         */
+        Rolling<Series_t, DateTime_t>
+        rolling(typename DateTime_t::duration_type span) const;
+        
+        Rolling<Series_t, DateTime_t>
+        rolling(std::vector<typename DateTime_t::duration_type> spans) const;
+        
+        /**
+         @author: agent
+         @param alpha: smoothing factor, in (0,1]
+         @return: EWM object from which exponentially weighted
+         statistics can be computed, see rolling.hpp
+         */
+        EWM<Series_t, DateTime_t> ewm(double alpha) const;
+        
+        EWM<Series_t, DateTime_t> ewm(std::vector<double> alphas) const;
+        
         
 
     };
@@ -5,14 +5,16 @@
  @brief: base class for models in TimeSeries
  */
 #include "base.hpp"
+#include <limits>
+#include <tuple>
 #include <vector>
 #include <utility>
 
 namespace TimeSeries
 {
-    //stores results of a model; T is the type of parameters
-    //RetPars are other model parameters
-    template<typename T = double, typename RetPars...>
+    //stores results of a model; T is the type of parameters,
+    //e.g. float for a ts<float>. RetPars are other model parameters
+    template<typename T = double, typename... RetPars>
     struct ModelOutput
     {
         std::vector<T>          params;
@@ -24,7 +26,7 @@ namespace TimeSeries
     /**
      ts_type is a time series type, e.g. ts
      */
-    template<typename ts_type, out_t>
+    template<typename ts_type, typename out_t>
     class Model
     {
     protected:
@@ -32,16 +34,18 @@ namespace TimeSeries
         out_t   result;
         
     public:
-        //fitting method
-        virtual out_t fit();
+        virtual ~Model() = default;
         
-        //returns log likelihood of model
-        virtual double logLik();
+        //fitting method; models override this, the default returns the last result
+        virtual out_t fit() { return result; }
+        
+        //returns log likelihood of model, NaN unless the model provides one
+        virtual double logLik() { return std::numeric_limits<double>::quiet_NaN(); }
         
         //prints a summary
-        virtual void summary();
+        virtual void summary() {}
         
-        virtual std::vector<Param_t> params();
+        virtual decltype(out_t::params) params() { return result.params; }
     };
     
     
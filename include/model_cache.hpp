@@ -0,0 +1,165 @@
+/**
+ @author: agent
+ @brief: binary serialization of fitted ARMA/ARIMA state and an on-disk
+ cache of that state keyed by series id, so a refit on a series that
+ only gained new observations can warm-start from the cached fit
+ */
+#ifndef TS_MODEL_CACHE_HPP
+#define TS_MODEL_CACHE_HPP
+
+#include "base.hpp"
+#include "arima.hpp"
+#include "model_base.hpp"
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace TimeSeries
+{
+    /**
+     @author: agent
+     @brief: identifies the data a model was fit on by the number of
+     observations and an FNV-1a hash of their bytes. FNV-1a is streamed
+     one observation at a time, so the hash of a prefix can be checked
+     against a longer series without rereading the cached data.
+     */
+    struct SeriesFingerprint
+    {
+        uint64_t length = 0;
+        uint64_t hash   = 14695981039346656037ULL;
+
+        //folds the next observation into the hash
+        template<typename T>
+        void update(T x) noexcept;
+
+        bool operator==(const SeriesFingerprint& other) const noexcept
+        {
+            return length == other.length and hash == other.hash;
+        }
+
+        bool operator!=(const SeriesFingerprint& other) const noexcept
+        {
+            return not (*this == other);
+        }
+    };
+
+    /**
+     @author: agent
+     @param series: data to fingerprint
+     @param prefix: number of leading observations to hash; the whole
+     series if not given
+     @return: fingerprint of series[0, prefix)
+     */
+    template<typename T>
+    extern SeriesFingerprint fingerprint(const Vec<T>& series,
+                                         std::optional<size_t> prefix = std::nullopt);
+
+    /**
+     @author: agent
+     @brief: everything needed to resume an ARMA/ARIMA fit, in space that
+     does not grow with the series. output is the model's ARIMAOutput
+     with only the last max(p, q) residuals, which seed the filter when
+     new observations arrive; resid_count and resid_sse are the number
+     and sum of squares of all the residuals the innovation variance is
+     taken over, so it can be updated exactly. obs_tail holds the last
+     max(p, q) + d observations of the undifferenced series, from which
+     new observations are differenced.
+     */
+    template<typename T = double>
+    struct ModelState
+    {
+        ARIMAOutput<T>      output;
+        Vec<T>              obs_tail;
+        uint64_t            resid_count = 0;
+        accumulator_t<T>    resid_sse   = 0;
+        SeriesFingerprint   fingerprint;
+    };
+
+    /**
+     @author: agent
+     @param output: output of a model fit on the whole of series, with
+     residuals for the whole (differenced) series
+     @param series: series the model was fit on
+     @return: ModelState holding output cut down to its residual tail,
+     the residual count and sum of squares, the observation tail and the
+     fingerprint of series
+     */
+    template<typename T>
+    extern ModelState<T> make_state(const ARIMAOutput<T>& output,
+                                    const Vec<T>& series);
+
+    /**
+     @author: agent
+     @param cached: state of a fit on a prefix of series
+     @param update: output extending that fit, with residuals for the
+     observations series has gained since
+     @param series: the whole series
+     @return: cached advanced over the new observations, without
+     rereading the prefix
+     */
+    template<typename T>
+    extern ModelState<T> extend_state(const ModelState<T>& cached,
+                                      const ARIMAOutput<T>& update,
+                                      const Vec<T>& series);
+
+    /**
+     @author: agent
+     @brief: writes state in the compact binary format read by
+     read_state: a header (magic, format version, sizeof(T)) followed by
+     length-prefixed arrays. Throws SerializationError on stream failure
+     */
+    template<typename T>
+    extern void write_state(std::ostream& out, const ModelState<T>& state);
+
+    /* throws SerializationError on a bad header, precision mismatch, short
+     read or an array length longer than the rest of the stream */
+    template<typename T>
+    extern ModelState<T> read_state(std::istream& in);
+
+
+    /**
+     @author: agent
+     @brief: persistent cache of ModelStates, one file per series id
+     under a directory. Writes go to a temporary file that is renamed
+     into place, so a crashed run never leaves a partial entry, and a
+     failed write removes its temporary file.
+     */
+    class ModelCache
+    {
+    protected:
+        std::string dir;
+
+        std::string path_for(const std::string& series_id) const;
+
+    public:
+        /**
+         @author: agent
+         @param directory: cache directory, created if it does not exist
+         */
+        explicit ModelCache(std::string directory);
+
+        template<typename T>
+        void store(const std::string& series_id, const ModelState<T>& state) const;
+
+        //cached state for series_id, nullopt if absent or unreadable
+        template<typename T>
+        std::optional<ModelState<T>> load(const std::string& series_id) const;
+
+        /**
+         @author: agent
+         @param series_id: key of the series
+         @param series: current data of the series
+         @return: cached state if the data it was fit on is a prefix
+         of series, else nullopt
+         */
+        template<typename T>
+        std::optional<ModelState<T>>
+        lookup(const std::string& series_id, const Vec<T>& series) const;
+
+        void erase(const std::string& series_id) const;
+    };
+
+}//end namespace TimeSeries
+#endif//TS_MODEL_CACHE_HPP
@@ -9,11 +9,17 @@
 namespace TimeSeries
 {
     template<typename T>
-    using Mat<T> = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+    using Mat = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
     
     template<typename T>
     extern Mat<T> ols_model_matrix(Mat<T>& X);
     
+    /**
+     @author: agent
+     @return: OLS coefficients in the precision of y and X. The QR
+     solve runs in accumulator_t<T>, so float inputs are solved in
+     double and rounded once at the end
+     */
     template<typename T>
     extern std::vector<T> ols_fit(Vec<T>& y, Mat<T>& X);
     
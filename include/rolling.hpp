@@ -0,0 +1,272 @@
+/**
+ @author: agent
+ @brief: rolling-window and exponentially weighted statistics on ts
+ objects. All windows passed to one Rolling object are computed in a
+ single sweep over the data, with O(1) amortized work per step for
+ moments (Welford add/remove, rebuilt from the window when a large value
+ leaving it would otherwise cost precision) and min/max, and
+ O(log window) for quantiles.
+ */
+#ifndef TS_ROLLING_HPP
+#define TS_ROLLING_HPP
+
+#include "base.hpp"
+#include "model_fit.hpp"
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace TimeSeries
+{
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                streaming kernels
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    /**
+     @author: agent
+     @brief: monotonic deque of (index, value) pairs. With Compare =
+     std::less<T> the front is the window minimum, with std::greater<T>
+     the window maximum. Each element is pushed and popped at most once.
+     */
+    template<typename T, typename Compare = std::less<T>>
+    class MonotonicDeque
+    {
+    protected:
+        std::deque<std::pair<size_t, T>> q;
+        Compare                          comp;
+
+    public:
+        /**
+         @author: agent
+         @param idx: position of x in the series
+         @param x: new value entering the window
+         */
+        void push(size_t idx, T x)
+        {
+            while(not q.empty() and not comp(q.back().second, x)){
+                q.pop_back();
+            }
+            q.emplace_back(idx, x);
+        }
+
+        /**
+         @author: agent
+         @param first: index of the oldest element still in the window;
+         everything before it is dropped
+         */
+        void expire(size_t first)
+        {
+            while(not q.empty() and q.front().first < first){
+                q.pop_front();
+            }
+        }
+
+        bool empty() const noexcept { return q.empty(); }
+
+        T front() const { return q.front().second; }
+    };
+
+    /**
+     @author: agent
+     @brief: two-heap order statistic over a sliding window. The lower
+     multiset holds the smallest floor(q * (n - 1)) + 1 elements, so the
+     (linearly interpolated) q-quantile is read from the boundary.
+     multisets are used in place of binary heaps since they support
+     removal of the element leaving the window in O(log window).
+     */
+    template<typename T>
+    class WindowQuantile
+    {
+    protected:
+        std::multiset<T> lo;
+        std::multiset<T> hi;
+        double           q = 0.5;
+
+        void rebalance();
+
+    public:
+        /**
+         @author: agent
+         @param quantile: quantile to track, in [0,1]
+         */
+        explicit WindowQuantile(double quantile = 0.5) : q(quantile) {};
+
+        void insert(T x);
+
+        void erase(T x);
+
+        size_t size() const noexcept { return lo.size() + hi.size(); }
+
+        //quantile of the current window, NaN if the window is empty
+        double value() const;
+    };
+
+
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                rolling statistics
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    enum class RollingStat
+    {
+        Mean,
+        Var,
+        SD,
+        ZScore,
+        Min,
+        Max,
+        Quantile
+    };
+
+    /**
+     @author: agent
+     @brief: rolling-window statistics over one or more windows. Windows
+     are either a number of observations, or (if the series has time
+     labels) a span of time, in which case observation i's window holds
+     every observation j <= i with times[j] > times[i] - span.
+     Every statistic is returned as a matrix with one row per observation
+     and one column per window, in the order the windows were given.
+     Rows whose count-based window is not yet full are NaN. Non-finite
+     observations take up their place in a window but are left out of
+     every statistic.
+     float series are accumulated in double and returned as float,
+     integral series are returned as double.
+     */
+    template<
+        typename Series_t,
+        typename DateTime_t = boost::gregorian::date
+        >
+    class Rolling
+    {
+    public:
+
+        typedef typename DateTime_t::duration_type duration_type;
+
+        //statistics are returned in result_type, accumulated in acc_type
+        typedef result_t<Series_t>      result_type;
+
+        typedef accumulator_t<Series_t> acc_type;
+
+    protected:
+
+        Vec<Series_t>                               data;
+        std::vector<DateTime_t>                     times;
+        std::vector<size_t>                         windows;
+        std::optional<std::vector<duration_type>>   spans;
+
+        //index of the first observation in window k for observation i
+        size_t window_start(size_t k, size_t i, size_t prev) const;
+
+        bool window_full(size_t k, size_t i) const;
+
+        //time labels of series, throws MissingTimeLabelsError if it has none
+        static std::vector<DateTime_t> labels_of(const ts<Series_t, DateTime_t>& series);
+
+    public:
+
+        Rolling(const ts<Series_t, DateTime_t>& series,
+                std::vector<size_t> _windows);
+
+        Rolling(const ts<Series_t, DateTime_t>& series,
+                std::vector<duration_type> _spans);
+
+        Rolling(const Vec<Series_t>& _data,
+                std::vector<size_t> _windows);
+
+        /**
+         @author: agent
+         @param _data: observations
+         @param _times: one label per observation, sorted
+         @param _spans: window lengths, all positive
+         */
+        Rolling(const Vec<Series_t>& _data,
+                std::vector<DateTime_t> _times,
+                std::vector<duration_type> _spans);
+
+        size_t num_windows() const noexcept;
+
+        /**
+         @author: agent
+         @param stats: statistics to compute
+         @param quantile: quantile used for RollingStat::Quantile, in [0,1]
+         @return: one matrix per entry of stats, all filled in a single
+         pass over the data
+         */
+        std::vector<Mat<result_type>>
+        compute(const std::vector<RollingStat>& stats,
+                double quantile = 0.5) const;
+
+        Mat<result_type> mean() const;
+
+        Mat<result_type> var() const;
+
+        Mat<result_type> sd() const;
+
+        //(x_i - rolling mean) / rolling sd
+        Mat<result_type> zscore() const;
+
+        Mat<result_type> min() const;
+
+        Mat<result_type> max() const;
+
+        Mat<result_type> median() const;
+
+        Mat<result_type> quantile(double q) const;
+    };
+
+
+    /**
+     @author: agent
+     @brief: exponentially weighted moving statistics for one or more
+     smoothing factors, computed in a single pass. For each alpha,
+     mean_i = mean_{i-1} + alpha * (x_i - mean_{i-1}), and the variance
+     follows the matching exponentially weighted recursion.
+     Columns of each result are in the order the alphas were given.
+     */
+    template<
+        typename Series_t,
+        typename DateTime_t = boost::gregorian::date
+        >
+    class EWM
+    {
+    public:
+
+        typedef result_t<Series_t>      result_type;
+
+        typedef accumulator_t<Series_t> acc_type;
+
+    protected:
+
+        Vec<Series_t>       data;
+        std::vector<double> alphas;
+
+    public:
+
+        EWM(const ts<Series_t, DateTime_t>& series,
+            std::vector<double> _alphas);
+
+        EWM(const Vec<Series_t>& _data,
+            std::vector<double> _alphas);
+
+        //statistics supported are Mean, Var, SD and ZScore
+        std::vector<Mat<result_type>>
+        compute(const std::vector<RollingStat>& stats) const;
+
+        Mat<result_type> mean() const;
+
+        Mat<result_type> var() const;
+
+        Mat<result_type> sd() const;
+
+        Mat<result_type> zscore() const;
+    };
+
+}//end namespace TimeSeries
+#endif//TS_ROLLING_HPP
@@ -0,0 +1,241 @@
+/**
+ @author: agent
+ @brief: library-wide work-stealing thread pool used by every parallel
+ algorithm in TimeSeries. Workers are pinned to CPUs grouped by NUMA
+ node (compile with -DTS_USE_NUMA and link libnuma for node detection),
+ and tasks run with MKL/OpenMP forced single-threaded so that nested
+ BLAS calls inside per-series tasks do not oversubscribe the machine.
+ The thread count defaults to the TS_NUM_THREADS environment variable,
+ or if it is unset the number of CPUs in the process's affinity mask
+ (the number of hardware threads where that cannot be read). Setting
+ TS_PIN_THREADS=0 leaves workers unpinned, for processes that share the
+ machine or manage affinity themselves; see also Scheduler::set_pinning.
+ */
+#ifndef TS_SCHEDULER_HPP
+#define TS_SCHEDULER_HPP
+
+#include "base.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace TimeSeries
+{
+    /**
+     @author: agent
+     @brief: RAII guard that makes MKL and OpenMP (and so Eigen's
+     OpenMP path) single-threaded on the calling thread, restoring the
+     previous settings on destruction. Only thread-local settings are
+     touched, so threads outside the guard are unaffected.
+     */
+    class SerialBackendGuard
+    {
+    protected:
+        int omp_threads = 0;
+        int mkl_threads = 0;
+
+    public:
+        SerialBackendGuard();
+
+        ~SerialBackendGuard();
+
+        SerialBackendGuard(const SerialBackendGuard&) = delete;
+
+        SerialBackendGuard& operator=(const SerialBackendGuard&) = delete;
+    };
+
+    /**
+     @author: agent
+     @brief: set of tasks that can be waited on together. The first
+     exception thrown by any task is rethrown by Scheduler::wait.
+     */
+    class TaskGroup
+    {
+    protected:
+        std::atomic<size_t>     remaining {0};
+        std::exception_ptr      error;
+        std::mutex              error_mutex;
+        
+        //remaining only reaches 0 under done_mutex, and done is then signalled
+        std::mutex              done_mutex;
+        std::condition_variable done;
+
+        friend class Scheduler;
+
+    public:
+        TaskGroup() {};
+
+        TaskGroup(const TaskGroup&) = delete;
+
+        TaskGroup& operator=(const TaskGroup&) = delete;
+    };
+
+    /**
+     @author: agent
+     @brief: work-stealing scheduler. Each worker owns a deque of tasks;
+     it runs its own tasks newest-first and, when idle, steals the oldest
+     task of another worker, trying workers on its own NUMA node first.
+     */
+    class Scheduler
+    {
+    protected:
+
+        struct Task
+        {
+            std::function<void()>   fn;
+            TaskGroup*              group = nullptr;
+        };
+
+        struct Worker
+        {
+            std::deque<Task>    tasks;
+            std::mutex          mutex;
+            std::thread         thread;
+            size_t              node = 0;
+            std::optional<int>  cpu;
+        };
+
+        std::vector<std::unique_ptr<Worker>>    workers;
+        size_t                                  nodes = 1;
+
+        std::atomic<bool>                       stopping {false};
+        std::atomic<size_t>                     queued {0};
+        std::atomic<size_t>                     next_worker {0};
+        std::mutex                              sleep_mutex;
+        std::condition_variable                 wakeup;
+
+        std::atomic<bool>                       nested {false};
+        std::atomic<bool>                       serial_backends {true};
+        bool                                    pinning = true;
+
+        Scheduler();
+
+        void start(size_t nThreads);
+
+        void stop();
+
+        void worker_loop(size_t id);
+
+        //pops a task from worker self (or steals one) and runs it; workers only
+        bool run_one(size_t self);
+
+        std::optional<Task> steal(size_t self);
+
+        void execute(Task& task);
+
+    public:
+
+        //the process-wide scheduler, started on first use
+        static Scheduler& instance();
+
+        ~Scheduler();
+
+        Scheduler(const Scheduler&) = delete;
+
+        Scheduler& operator=(const Scheduler&) = delete;
+
+        /**
+         @author: agent
+         @param nThreads: number of worker threads, >= 1. Restarts the
+         pool; must not be called from inside a task
+         */
+        void set_num_threads(size_t nThreads);
+
+        size_t num_threads() const noexcept;
+
+        //number of NUMA nodes the workers are spread over
+        size_t num_nodes() const noexcept;
+
+        //NUMA node of worker id
+        size_t node_of(size_t id) const;
+
+        /**
+         @author: agent
+         @param pin: if true (the default unless TS_PIN_THREADS=0), each
+         worker is pinned to one CPU; if false workers may run anywhere in
+         the process's affinity mask, though stealing still prefers the
+         same NUMA node. Restarts the pool if the setting changes; must not
+         be called from inside a task
+         */
+        void set_pinning(bool pin);
+
+        bool pinned() const noexcept;
+
+        /**
+         @author: agent
+         @param allow: if false (the default), parallel_for called from
+         inside a task runs serially on that task's thread instead of
+         fanning out again
+         */
+        void set_nested(bool allow) noexcept;
+
+        /**
+         @author: agent
+         @param force: if true (the default), every task runs under a
+         SerialBackendGuard
+         */
+        void set_serial_backends(bool force) noexcept;
+
+        //id of the calling worker, nullopt if not called from a worker
+        static std::optional<size_t> worker_id() noexcept;
+
+        /**
+         @author: agent
+         @param group: group the task is counted in
+         @param fn: task to run
+         @param worker: worker whose queue the task starts on; idle
+         workers may still steal it. Defaults to the calling worker, or
+         round-robin from outside the pool
+         */
+        void run(TaskGroup& group,
+                 std::function<void()> fn,
+                 std::optional<size_t> worker = std::nullopt);
+
+        /**
+         @author: agent
+         @brief: blocks until every task in group is done. A worker runs
+         queued tasks meanwhile and sleeps on the group when there are
+         none; any other thread sleeps until the last task finishes and
+         never runs tasks itself, so every task runs on a worker
+         */
+        void wait(TaskGroup& group);
+
+        /**
+         @author: agent
+         @param begin: first index
+         @param end: one past the last index
+         @param grain: indices per task, >= 1
+         @param body: called as body(chunkBegin, chunkEnd) on each chunk
+         @brief: contiguous chunks are mapped to contiguous workers, and
+         so to the same NUMA node on every call with the same range and
+         grain. Data first touched through parallel_for (see
+         first_touch_copy) is therefore processed on the node it lives on
+         */
+        void parallel_for(size_t begin,
+                          size_t end,
+                          size_t grain,
+                          const std::function<void(size_t, size_t)>& body);
+    };
+
+    /**
+     @author: agent
+     @param src: data to copy
+     @param grain: chunk size that will later be passed to parallel_for
+     over the copy
+     @return: copy of src whose pages were first written (and so, under
+     Linux's first-touch policy, placed) by the workers that parallel_for
+     assigns each chunk to
+     */
+    template<typename T>
+    extern Vec<T> first_touch_copy(const Vec<T>& src, size_t grain);
+
+}//end namespace TimeSeries
+#endif//TS_SCHEDULER_HPP
@@ -8,7 +8,11 @@ namespace TimeSeries
         Success                         = 0,
         NonContainerTypeError           = 1,
         NonArithmeticTypeError          = 2,
-        NonConvertibleDateTimeError     = 3
+        NonConvertibleDateTimeError     = 3,
+        InvalidWindowError              = 4,
+        MissingTimeLabelsError          = 5,
+        InvalidParameterError           = 6,
+        SerializationError              = 7
     };
 }
 
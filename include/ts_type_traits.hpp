@@ -74,6 +74,43 @@ namespace TimeSeries
                       is_unbounded_array<T>::value);
     };
     */
+    /**
+     *@author: agent
+     *@param T: storage type of a series
+     *@brief: type in which sums over a series of T are accumulated.
+     float series are accumulated in double so that storage can be
+     kept in single precision without losing accuracy in long sums;
+     integral series are accumulated in double.
+     */
+    template<typename T, typename _ = void>
+    struct accumulator_type
+    {
+        typedef double type;
+    };
+    
+    template<typename T>
+    struct accumulator_type<T,
+                            typename enable_if<
+                                is_floating_point<T>::value and
+                                (sizeof(T) > sizeof(float))
+                            >::type
+                        >
+    {
+        typedef T type;
+    };
+    
+    template<typename T>
+    using accumulator_t = typename accumulator_type<T>::type;
+    
+    /**
+     *@author: agent
+     *@param T: storage type of a series
+     *@brief: type in which statistics of a series of T are returned:
+     T itself if T is floating point, else double
+     */
+    template<typename T>
+    using result_t = conditional_t<is_floating_point<T>::value, T, double>;
+    
     //gets number of elements in a C-array
     template<typename T, size_t N>
     constexpr size_t C_array_size(T(&)[N])
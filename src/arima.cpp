@@ -0,0 +1,488 @@
+/**
+ @author: agent
+ @brief: implementation of arima.hpp
+ */
+#include "../include/arima.hpp"
+#include "../include/model_fit.hpp"
+#include "../include/model_cache.hpp"
+#include "../include/scheduler.hpp"
+#include "../include/ts_error.hpp"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace TimeSeries
+{
+    //multiply-adds per ACF task; series at least this long get one lag per task
+    constexpr size_t acf_task_work = 1 << 18;
+    
+    namespace
+    {
+        /**
+         @author: agent
+         @return: autocorrelations at lags 0, ..., length in accumulator
+         precision, so pACF can run Durbin-Levinson without first
+         rounding them to the storage type
+         */
+        template<typename T>
+        Vec<accumulator_t<T>> autocorrelation(const Vec<T>& series, size_t length)
+        {
+            if constexpr(!std::is_arithmetic<T>::value){
+                throw TimeSeries::NonArithmeticTypeError;
+            }
+            
+            typedef accumulator_t<T> acc;
+            const size_t n = series.size();
+            if(n == 0 or length >= n){
+                throw TimeSeries::InvalidParameterError;
+            }
+            
+            acc mean = series.template cast<acc>().sum() / static_cast<acc>(n);
+            /* keep the centered series in storage precision (half the
+             bandwidth for float) and only widen inside the dot products;
+             integral series are centered in double, not truncated */
+            typedef result_t<T> center_t;
+            Vec<center_t> centered = (series.template cast<acc>().array() - mean)
+                                        .template cast<center_t>();
+            
+            acc c0 = centered.template cast<acc>().squaredNorm();
+            Vec<acc> rho(length + 1);
+            rho[0] = 1;
+            auto lags = [&](size_t first, size_t last){
+                for(size_t k = first; k < last; k++){
+                    acc ck = centered.tail(n - k).template cast<acc>()
+                                .dot(centered.head(n - k).template cast<acc>());
+                    rho[k] = ck / c0;
+                }
+            };
+            //lags are independent, so long series are split across the scheduler
+            const size_t grain = std::max<size_t>(1, acf_task_work / n);
+            Scheduler::instance().parallel_for(1, length + 1, grain, lags);
+            return rho;
+        }
+        
+        /**
+         @author: agent
+         @brief: out_t = x_t - sum_j theta_j out_{t-j} for t >= first, i.e.
+         x filtered through the inverse MA polynomial. out[0, first) is
+         taken as given and lags before the start count as 0. Sums are
+         accumulated in acc
+         */
+        template<typename acc, typename T, typename Theta>
+        void ma_invert(const Theta& theta, const Vec<T>& x, Vec<T>& out, size_t first)
+        {
+            const size_t n = x.size();
+            const size_t q = theta.size();
+            for(size_t t = first; t < n; t++){
+                acc et = x[t];
+                for(size_t j = 1; j <= std::min(q, t); j++){
+                    et -= static_cast<acc>(theta[j - 1]) * out[t - j];
+                }
+                out[t] = static_cast<T>(et);
+            }
+        }
+        
+        //w_t = z_t - sum_i phi_i z_{t-i} for t >= first, 0 before
+        template<typename acc, typename T, typename Phi>
+        Vec<T> ar_residuals(const Phi& phi, const Vec<T>& z, size_t first)
+        {
+            const size_t n = z.size();
+            const size_t p = phi.size();
+            Vec<T> w = Vec<T>::Zero(n);
+            for(size_t t = first; t < n; t++){
+                acc wt = z[t];
+                for(size_t i = 1; i <= std::min(p, t); i++){
+                    wt -= static_cast<acc>(phi[i - 1]) * z[t - i];
+                }
+                w[t] = static_cast<T>(wt);
+            }
+            return w;
+        }
+        
+        //series differenced d times
+        template<typename T>
+        Vec<T> difference(Vec<T> x, size_t d)
+        {
+            for(size_t k = 0; k < d and x.size() > 0; k++){
+                const Eigen::Index n = x.size() - 1;
+                Vec<T> dx = x.tail(n) - x.head(n);
+                x = std::move(dx);
+            }
+            return x;
+        }
+    }
+    
+    template<typename T>
+    Vec<result_t<T>> ACF(const Vec<T>& series, size_t length)
+    {
+        return autocorrelation(series, length).template cast<result_t<T>>();
+    }
+    
+    template<typename T>
+    Vec<result_t<T>> pACF(const Vec<T>& series, size_t length)
+    {
+        typedef accumulator_t<T> acc;
+        Vec<acc> rho = autocorrelation(series, length);
+        
+        //Durbin-Levinson recursion, run in accumulator precision
+        Vec<result_t<T>> pacf(length);
+        Vec<acc> phi = Vec<acc>::Zero(length + 1);
+        Vec<acc> prev = Vec<acc>::Zero(length + 1);
+        for(size_t k = 1; k <= length; k++){
+            acc num = rho[k];
+            acc den = 1;
+            for(size_t j = 1; j < k; j++){
+                num -= prev[j] * rho[k - j];
+                den -= prev[j] * rho[j];
+            }
+            phi[k] = num / den;
+            for(size_t j = 1; j < k; j++){
+                phi[j] = prev[j] - phi[k] * prev[k - j];
+            }
+            pacf[k - 1] = static_cast<result_t<T>>(phi[k]);
+            prev = phi;
+        }
+        return pacf;
+    }
+    
+    template Vec<float>  ACF(const Vec<float>& series, size_t length);
+    template Vec<double> ACF(const Vec<double>& series, size_t length);
+    template Vec<double> ACF(const Vec<int>& series, size_t length);
+    template Vec<float>  pACF(const Vec<float>& series, size_t length);
+    template Vec<double> pACF(const Vec<double>& series, size_t length);
+    template Vec<double> pACF(const Vec<int>& series, size_t length);
+    
+    
+    template<typename T>
+    void ARMA_filter(const std::vector<T>& params,
+                     size_t p,
+                     size_t q,
+                     const Vec<T>& z,
+                     Vec<T>& e,
+                     size_t first)
+    {
+        if(params.size() != p + q or e.size() != z.size()){
+            throw TimeSeries::InvalidParameterError;
+        }
+        typedef accumulator_t<T> acc;
+        const size_t n = z.size();
+        for(size_t t = first; t < n; t++){
+            acc et = z[t];
+            for(size_t i = 1; i <= std::min(p, t); i++){
+                et -= static_cast<acc>(params[i - 1]) * z[t - i];
+            }
+            for(size_t j = 1; j <= std::min(q, t); j++){
+                et -= static_cast<acc>(params[p + j - 1]) * e[t - j];
+            }
+            e[t] = static_cast<T>(et);
+        }
+    }
+    
+    template<typename T>
+    std::vector<T> CSS_fit(const Vec<T>& z,
+                           size_t p,
+                           size_t q,
+                           std::optional<std::vector<T>> start,
+                           size_t maxIter,
+                           double tol)
+    {
+        typedef accumulator_t<T> acc;
+        const size_t n = z.size();
+        const size_t k = p + q;
+        if(n <= k){
+            throw TimeSeries::InvalidParameterError;
+        }
+        if(k == 0){
+            return {};
+        }
+        
+        //the whole optimization runs in acc, parameters are rounded once at the end
+        Vec<acc> zz = z.template cast<acc>();
+        Vec<acc> theta = Vec<acc>::Zero(k);
+        if(start and start->size() == k){
+            for(size_t i = 0; i < k; i++){
+                theta[i] = static_cast<acc>((*start)[i]);
+            }
+        } else if(p > 0){
+            //cold start: AR part from OLS on p lags, MA part at 0
+            Mat<acc> X(n - p, p);
+            for(size_t i = 1; i <= p; i++){
+                X.col(i - 1) = zz.segment(p - i, n - p);
+            }
+            Vec<acc> y = zz.tail(n - p);
+            auto phi = ols_fit(y, X);
+            for(size_t i = 0; i < p; i++){
+                theta[i] = phi[i];
+            }
+        }
+        
+        //CSS residuals e_t for t >= p, with e_t = 0 before
+        auto residuals = [&](const Vec<acc>& par){
+            Vec<acc> e = Vec<acc>::Zero(n);
+            ma_invert<acc>(par.tail(q), ar_residuals<acc>(par.head(p), zz, p), e, p);
+            return e;
+        };
+        
+        Vec<acc> e = residuals(theta);
+        acc sse = e.squaredNorm();
+        for(size_t iter = 0; iter < maxIter and std::isfinite(sse); iter++){
+            /* de/dphi_i and de/dtheta_j are -z_{t-i} and -e_{t-j} passed
+             through the same inverse MA filter as the residuals */
+            Mat<acc> J = Mat<acc>::Zero(n - p, k);
+            Vec<acc> shifted = Vec<acc>::Zero(n);
+            Vec<acc> dcol = Vec<acc>::Zero(n);
+            for(size_t c = 0; c < k; c++){
+                const Vec<acc>& src = (c < p) ? zz : e;
+                const size_t lag = (c < p) ? c + 1 : c - p + 1;
+                shifted.setZero();
+                for(size_t t = std::max(p, lag); t < n; t++){
+                    shifted[t] = -src[t - lag];
+                }
+                dcol.setZero();
+                ma_invert<acc>(theta.tail(q), shifted, dcol, p);
+                J.col(c) = dcol.tail(n - p);
+            }
+            
+            Vec<acc> rhs = -e.tail(n - p);
+            auto delta = ols_fit(rhs, J);
+            Vec<acc> step = Eigen::Map<Vec<acc>>(delta.data(), k);
+            
+            //halve the Gauss-Newton step until the sum of squares goes down
+            bool improved = false;
+            acc scale = 1;
+            for(int h = 0; h < 30; h++, scale /= 2){
+                Vec<acc> trial = theta + scale * step;
+                Vec<acc> eTrial = residuals(trial);
+                acc sseTrial = eTrial.squaredNorm();
+                if(std::isfinite(sseTrial) and sseTrial < sse){
+                    improved = (sse - sseTrial) > tol * sse;
+                    theta = trial;
+                    e = eTrial;
+                    sse = sseTrial;
+                    break;
+                }
+            }
+            if(not improved){
+                break;
+            }
+        }
+        
+        std::vector<T> params(k);
+        for(size_t i = 0; i < k; i++){
+            params[i] = static_cast<T>(theta[i]);
+        }
+        return params;
+    }
+    
+    template void ARMA_filter(const std::vector<float>& params, size_t p, size_t q,
+                              const Vec<float>& z, Vec<float>& e, size_t first);
+    template void ARMA_filter(const std::vector<double>& params, size_t p, size_t q,
+                              const Vec<double>& z, Vec<double>& e, size_t first);
+    template std::vector<float>  CSS_fit(const Vec<float>& z, size_t p, size_t q,
+                                         std::optional<std::vector<float>> start,
+                                         size_t maxIter, double tol);
+    template std::vector<double> CSS_fit(const Vec<double>& z, size_t p, size_t q,
+                                         std::optional<std::vector<double>> start,
+                                         size_t maxIter, double tol);
+    
+    
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                    ARMA fitting
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+    
+    template<typename ts_type>
+    ARMA<ts_type>::ARMA(ts_type& tseries)
+    {
+        this->series = tseries;
+    }
+    
+    template<typename ts_type>
+    ARMA<ts_type>::ARMA(const ts_type& tseries)
+    {
+        this->series = tseries;
+    }
+    
+    template<typename ts_type>
+    void ARMA<ts_type>::setOrder(vector<size_t> newOrder)
+    {
+        if(newOrder.size() != 3){
+            throw TimeSeries::InvalidParameterError;
+        }
+        order = std::move(newOrder);
+    }
+    
+    template<typename ts_type>
+    Vec<typename ARMA<ts_type>::value_type> ARMA<ts_type>::resids()
+    {
+        if(not isFit){
+            throw TimeSeries::InvalidParameterError;
+        }
+        return std::get<2>(this->result.outs);
+    }
+    
+    template<typename ts_type>
+    typename ARMA<ts_type>::output_type ARMA<ts_type>::fit()
+    {
+        return fit(order);
+    }
+    
+    template<typename ts_type>
+    typename ARMA<ts_type>::output_type ARMA<ts_type>::fit(std::vector<size_t> fixedOrder)
+    {
+        setOrder(std::move(fixedOrder));
+        const size_t p = order[0];
+        const size_t d = order[1];
+        const size_t q = order[2];
+        
+        Vec<value_type> values = this->series.getData().template cast<value_type>();
+        Vec<value_type> diffed = difference(std::move(values), d);
+        const Eigen::Index n = diffed.size();
+        if(n <= static_cast<Eigen::Index>(p + q)){
+            throw TimeSeries::InvalidParameterError;
+        }
+        
+        acc_type mean = diffed.template cast<acc_type>().sum() / static_cast<acc_type>(n);
+        Vec<value_type> z = (diffed.template cast<acc_type>().array() - mean)
+                                .template cast<value_type>();
+        
+        //start_params, if set by warm_start, seed the optimizer
+        auto params = CSS_fit(z, p, q, start_params);
+        Vec<value_type> e = Vec<value_type>::Zero(n);
+        ARMA_filter(params, p, q, z, e, p);
+        acc_type sigma2 = e.template cast<acc_type>().squaredNorm()
+                            / static_cast<acc_type>(n - p);
+        
+        output_type out;
+        out.params = params;
+        out.status = TimeSeries::Success;
+        out.outs = std::make_tuple(
+            std::vector<value_type>{static_cast<value_type>(mean),
+                                    static_cast<value_type>(sigma2)},
+            std::make_pair(std::vector<size_t>{p, d, q, 0}, std::vector<size_t>{0, 0, 0}),
+            e);
+        
+        this->result = out;
+        isFit = true;
+        return out;
+    }
+    
+    
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                ARMA warm starts
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+    
+    template<typename ts_type>
+    ModelState<typename ARMA<ts_type>::value_type>
+    ARMA<ts_type>::state() const
+    {
+        Vec<value_type> values = this->series.getData().template cast<value_type>();
+        //make_state needs residuals for the whole differenced series
+        const auto& e = std::get<2>(this->result.outs);
+        if(not isFit or e.size() + static_cast<Eigen::Index>(order[1]) != values.size()){
+            throw TimeSeries::InvalidParameterError;
+        }
+        return make_state(this->result, values);
+    }
+    
+    template<typename ts_type>
+    void ARMA<ts_type>::warm_start(const ModelState<value_type>& cached)
+    {
+        //cached order is (p,d,q,num_exog)
+        const auto& cachedOrder = std::get<1>(cached.output.outs).first;
+        if(cachedOrder.size() >= 3){
+            setOrder({cachedOrder[0], cachedOrder[1], cachedOrder[2]});
+        }
+        start_params = cached.output.params;
+    }
+    
+    template<typename ts_type>
+    typename ARMA<ts_type>::output_type
+    ARMA<ts_type>::update(const ModelState<value_type>& cached,
+                          const Vec<value_type>& values) const
+    {
+        const auto& cachedOrder = std::get<1>(cached.output.outs).first;
+        const size_t p = cachedOrder[0];
+        const size_t d = cachedOrder[1];
+        const size_t q = cachedOrder[2];
+        const auto& extra = std::get<0>(cached.output.outs);
+        const auto& residTail = std::get<2>(cached.output.outs);
+        const size_t n0 = cached.fingerprint.length;
+        const size_t added = values.size() - n0;
+        
+        /* difference the cached observation tail together with the new
+         observations; the first c differenced values (and the last c
+         cached residuals) are the filter's lag context */
+        const auto& obsTail = cached.obs_tail;
+        Vec<value_type> raw(obsTail.size() + added);
+        raw << obsTail, values.tail(added);
+        Vec<value_type> z = (difference(std::move(raw), d).template cast<acc_type>().array()
+                                - static_cast<acc_type>(extra[0])).template cast<value_type>();
+        const size_t c = z.size() - added;
+        
+        Vec<value_type> e = Vec<value_type>::Zero(z.size());
+        e.head(c) = residTail.tail(c);
+        ARMA_filter(cached.output.params, p, q, z, e, c);
+        
+        output_type out = cached.output;
+        std::get<2>(out.outs) = e.tail(added);
+        
+        //fold the new squared residuals into the innovation variance
+        acc_type sse = cached.resid_sse + e.tail(added).template cast<acc_type>().squaredNorm();
+        std::get<0>(out.outs)[1] = static_cast<value_type>(sse / (cached.resid_count + added));
+        return out;
+    }
+    
+    template<typename ts_type>
+    typename ARMA<ts_type>::output_type
+    ARMA<ts_type>::fit(const ModelCache& cache,
+                       const std::string& series_id,
+                       bool refit)
+    {
+        Vec<value_type> values = this->series.getData().template cast<value_type>();
+        auto cached = cache.template lookup<value_type>(series_id, values);
+        
+        if(cached and cached->fingerprint.length == static_cast<uint64_t>(values.size())){
+            //no new observations since the cached fit, so no new residuals
+            warm_start(*cached);
+            this->result = cached->output;
+            std::get<2>(this->result.outs) = Vec<value_type>();
+            isFit = true;
+            return this->result;
+        }
+        
+        output_type out;
+        if(cached){
+            warm_start(*cached);
+            //obs_tail must hold the d observations the first new difference needs
+            if(not refit and cached->obs_tail.size() >= static_cast<Eigen::Index>(order[1])){
+                out = update(*cached, values);
+                this->result = out;
+                isFit = true;
+                cache.store(series_id, extend_state(*cached, out, values));
+                return out;
+            }
+            out = fit(order);
+        } else {
+            /* the series no longer extends the cached data, so the cached
+             parameters are no use, but a cached order still is */
+            if(auto stale = cache.template load<value_type>(series_id)){
+                const auto& cachedOrder = std::get<1>(stale->output.outs).first;
+                if(cachedOrder.size() >= 3){
+                    setOrder({cachedOrder[0], cachedOrder[1], cachedOrder[2]});
+                }
+            }
+            start_params.reset();
+            out = fit(order);
+        }
+        cache.store(series_id, make_state(out, values));
+        return out;
+    }
+    
+    
+    template class ARMA<ts<float>>;
+    template class ARMA<ts<double>>;
+}
@@ -11,12 +11,8 @@ namespace TimeSeries
     
     
     
-    template<
-        typename Series_t,
-        typename DateTime_t = boost::gregorian::date,
-        typename Con,
-        typename T
-        >
+    template<typename Series_t, typename DateTime_t>
+    template<typename Con, typename T>
     ts<Series_t, DateTime_t>::ts(Con& _data, T& _times) {
         //check that Series_t is arithmetic
         if(not std::is_arithmetic<Series_t>::value) {
@@ -82,47 +78,38 @@ namespace TimeSeries
     };
     
     //construct from data only
-    template<
-        typename Series_t,
-        typename DateTime_t = boost::gregorian::date,
-        typename Con
-        >
-    ts(Con& _data)
+    template<typename Series_t, typename DateTime_t>
+    template<typename Con, typename>
+    ts<Series_t, DateTime_t>::ts(Con& _data)
     {
         //check that Series_t is arithmetic
-        if(not std::is_arithmetic<Series_t>::value) {
+        if constexpr(not std::is_arithmetic<Series_t>::value) {
             throw TimeSeries::NonArithmeticTypeError;
         }
         
-        if(TimeSeries::is_1d_container<Con>::value) {
-            
+        //Eigen vectors are convertible but do not pass is_1d_container
+        if constexpr(std::is_convertible<Con, Vec<Series_t>>::value){
+            data = _data;
+            length = data.size();
+        } else if constexpr(TimeSeries::is_1d_container<Con>::value) {
+            //_data is iterable, but not convertible to a Vec<Series_t>
             length = _data.size();
-            //is it convertible to a Vec<Series_t>?
-            if(std::is_convertible<Con, Vec<Series_t>>::value){
-                data = _data;
-            } else {
-                //_data is iterable, but not convertible to a Vec<Series_t>
-                size_t i = 0;
-                data = Vec<Series_t>(length);
-                for(auto it : _data){
-                    data[i] = *it;
-                    i++;
-                }//end for
-            }//end else convertible to Vec<Series_t>
-        }//end if is_1d_container<Con>
-        else {
+            size_t i = 0;
+            data = Vec<Series_t>(length);
+            for(auto x : _data){
+                data[i] = x;
+                i++;
+            }//end for
+        } else {
             //error: _data is not a container type
             throw TimeSeries::NonContainerTypeError;
         }
     };
     
     
-    template<
-        typename Series_t,
-        typename DateTime_t = boost::gregorian::date
-        >
-    ts<Series_t, DateTime_t>::Vec<Series_t>
-    getData()
+    template<typename Series_t, typename DateTime_t>
+    Vec<Series_t>
+    ts<Series_t, DateTime_t>::getData()
     const noexcept
     {
         return data;
@@ -131,25 +118,66 @@ namespace TimeSeries
     
     
     //returns an iterator to data.begin()
-    template<
-        typename Series_t,
-        typename DateTime_t = boost::gregorian::date
-        >
-    ts<Series_t, DateTime_t>::Vec<Series_t>::iterator
-    dbegin()
+    template<typename Series_t, typename DateTime_t>
+    typename Vec<Series_t>::iterator
+    ts<Series_t, DateTime_t>::dbegin()
     const
     {
         return data.begin();
     }
     
-    template<
-        typename Series_t,
-        typename DateTime_t = boost::gregorian::date
-        >
-    ts<Series_t, DateTime_t>::Vec<Series_t>::iterator
-    dend()
+    template<typename Series_t, typename DateTime_t>
+    typename Vec<Series_t>::iterator
+    ts<Series_t, DateTime_t>::dend()
     const
     {
         return data.end();
     }
+    
+    template<typename Series_t, typename DateTime_t>
+    void ts<Series_t, DateTime_t>::setData(Vec<Series_t>& newData)
+    {
+        data = newData;
+        length = newData.size();
+    }
+    
+    template<typename Series_t, typename DateTime_t>
+    std::optional<DateVec<DateTime_t>>
+    ts<Series_t, DateTime_t>::getTimes() const
+    {
+        return times;
+    }
+    
+    template<typename Series_t, typename DateTime_t>
+    size_t ts<Series_t, DateTime_t>::getLength()
+    {
+        return length;
+    }
+    
+    template<typename Series_t, typename DateTime_t>
+    bool ts<Series_t, DateTime_t>::has_time_labels()
+    {
+        return times.has_value();
+    }
+    
+    
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                explicit instantiations
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+    
+    //the accessors that ts::rolling/ewm and the models go through
+    #define TS_INSTANTIATE_TS(T)                                                        \
+    template Vec<T> ts<T>::getData() const noexcept;                                    \
+    template void ts<T>::setData(Vec<T>&);                                              \
+    template std::optional<DateVec<boost::gregorian::date>> ts<T>::getTimes() const;    \
+    template size_t ts<T>::getLength();                                                 \
+    template bool ts<T>::has_time_labels();                                             \
+    template ts<T>::ts(Vec<T>&);
+    
+    TS_INSTANTIATE_TS(float)
+    TS_INSTANTIATE_TS(double)
+    
+    #undef TS_INSTANTIATE_TS
 }
@@ -0,0 +1,370 @@
+/**
+ @author: agent
+ @brief: implementation of model_cache.hpp
+ */
+#include "../include/model_cache.hpp"
+#include "../include/ts_error.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+namespace TimeSeries
+{
+    namespace
+    {
+        constexpr char     state_magic[4] = {'T', 'S', 'M', 'S'};
+        /* version 3: only the filter's residual tail is stored, with the
+         residual count and sum of squares; version 2 stored them all */
+        constexpr uint32_t state_version  = 3;
+
+        template<typename P>
+        void write_pod(std::ostream& out, const P& x)
+        {
+            out.write(reinterpret_cast<const char*>(&x), sizeof(P));
+        }
+
+        template<typename P>
+        P read_pod(std::istream& in)
+        {
+            P x;
+            if(not in.read(reinterpret_cast<char*>(&x), sizeof(P))){
+                throw TimeSeries::SerializationError;
+            }
+            return x;
+        }
+
+        //length-prefixed array of n elements starting at ptr
+        template<typename P>
+        void write_array(std::ostream& out, const P* ptr, uint64_t n)
+        {
+            write_pod(out, n);
+            out.write(reinterpret_cast<const char*>(ptr), n * sizeof(P));
+        }
+
+        template<typename P>
+        std::vector<P> read_array(std::istream& in)
+        {
+            auto n = read_pod<uint64_t>(in);
+            //a corrupt length must fail here, not as a huge allocation
+            auto here = in.tellg();
+            if(here != std::streampos(-1)){
+                in.seekg(0, std::ios::end);
+                auto end = in.tellg();
+                in.seekg(here);
+                if(end == std::streampos(-1) or
+                   n > static_cast<uint64_t>(end - here) / sizeof(P)){
+                    throw TimeSeries::SerializationError;
+                }
+            }
+            std::vector<P> v(n);
+            if(not in.read(reinterpret_cast<char*>(v.data()), n * sizeof(P))){
+                throw TimeSeries::SerializationError;
+            }
+            return v;
+        }
+
+        template<typename P>
+        Vec<P> read_vec(std::istream& in)
+        {
+            auto v = read_array<P>(in);
+            return Eigen::Map<Vec<P>>(v.data(), v.size());
+        }
+
+        void write_order(std::ostream& out, const std::vector<size_t>& order)
+        {
+            std::vector<uint64_t> wide(order.begin(), order.end());
+            write_array(out, wide.data(), wide.size());
+        }
+
+        std::vector<size_t> read_order(std::istream& in)
+        {
+            auto wide = read_array<uint64_t>(in);
+            return std::vector<size_t>(wide.begin(), wide.end());
+        }
+
+        //number of lagged residuals and observations the filter needs, max(p,q) and d
+        template<typename T>
+        std::pair<size_t, size_t> filter_lags(const ARIMAOutput<T>& output)
+        {
+            const auto& order = std::get<1>(output.outs).first;
+            //order is (p,d,q,num_exog)
+            size_t p = order.size() > 0 ? order[0] : 0;
+            size_t d = order.size() > 1 ? order[1] : 0;
+            size_t q = order.size() > 2 ? order[2] : 0;
+            return {std::max(p, q), d};
+        }
+    }
+
+    template<typename T>
+    void SeriesFingerprint::update(T x) noexcept
+    {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&x);
+        for(size_t b = 0; b < sizeof(T); b++){
+            hash ^= bytes[b];
+            hash *= 1099511628211ULL;
+        }
+        length++;
+    }
+
+    template<typename T>
+    SeriesFingerprint fingerprint(const Vec<T>& series, std::optional<size_t> prefix)
+    {
+        size_t n = prefix ? std::min<size_t>(*prefix, series.size()) : series.size();
+        SeriesFingerprint fp;
+        for(size_t i = 0; i < n; i++){
+            fp.update(series[i]);
+        }
+        return fp;
+    }
+
+    template<typename T>
+    ModelState<T> make_state(const ARIMAOutput<T>& output, const Vec<T>& series)
+    {
+        auto [lags, d] = filter_lags(output);
+        const auto& order = std::get<1>(output.outs).first;
+        const size_t p = order.empty() ? 0 : order[0];
+        const auto& resids = std::get<2>(output.outs);
+        
+        ModelState<T> state;
+        state.output = output;
+        //the first p CSS residuals are fixed at zero and not counted
+        state.resid_count = resids.size() > static_cast<Eigen::Index>(p) ? resids.size() - p : 0;
+        state.resid_sse = resids.template cast<accumulator_t<T>>().squaredNorm();
+        std::get<2>(state.output.outs) = resids.tail(std::min<Eigen::Index>(lags, resids.size()));
+        state.obs_tail = series.tail(std::min<Eigen::Index>(lags + d, series.size()));
+        state.fingerprint = fingerprint(series);
+        return state;
+    }
+    
+    template<typename T>
+    ModelState<T> extend_state(const ModelState<T>& cached,
+                               const ARIMAOutput<T>& update,
+                               const Vec<T>& series)
+    {
+        auto [lags, d] = filter_lags(update);
+        const auto& oldTail = std::get<2>(cached.output.outs);
+        const auto& added = std::get<2>(update.outs);
+        
+        ModelState<T> state;
+        state.output = update;
+        state.resid_count = cached.resid_count + added.size();
+        state.resid_sse = cached.resid_sse + added.template cast<accumulator_t<T>>().squaredNorm();
+        
+        Vec<T> resids(oldTail.size() + added.size());
+        resids << oldTail, added;
+        std::get<2>(state.output.outs) = resids.tail(std::min<Eigen::Index>(lags, resids.size()));
+        state.obs_tail = series.tail(std::min<Eigen::Index>(lags + d, series.size()));
+        
+        //the prefix was checked against the cached fingerprint, so only hash what is new
+        state.fingerprint = cached.fingerprint;
+        for(Eigen::Index i = cached.fingerprint.length; i < series.size(); i++){
+            state.fingerprint.update(series[i]);
+        }
+        return state;
+    }
+    
+    template<typename T>
+    void write_state(std::ostream& out, const ModelState<T>& state)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "ModelState parameters must be trivially copyable");
+
+        out.write(state_magic, sizeof(state_magic));
+        write_pod(out, state_version);
+        write_pod(out, static_cast<uint8_t>(sizeof(T)));
+        write_pod(out, static_cast<uint8_t>(std::is_floating_point<T>::value));
+
+        write_pod(out, state.fingerprint.length);
+        write_pod(out, state.fingerprint.hash);
+
+        const auto& output = state.output;
+        write_pod(out, static_cast<int32_t>(output.status));
+        write_array(out, output.params.data(), output.params.size());
+
+        const auto& extra   = std::get<0>(output.outs);
+        const auto& orders  = std::get<1>(output.outs);
+        const auto& resids  = std::get<2>(output.outs);
+        write_array(out, extra.data(), extra.size());
+        write_order(out, orders.first);
+        write_order(out, orders.second);
+        write_array(out, resids.data(), resids.size());
+        write_array(out, state.obs_tail.data(), state.obs_tail.size());
+        write_pod(out, state.resid_count);
+        write_pod(out, state.resid_sse);
+
+        if(not out){
+            throw TimeSeries::SerializationError;
+        }
+    }
+
+    template<typename T>
+    ModelState<T> read_state(std::istream& in)
+    {
+        char magic[sizeof(state_magic)];
+        if(not in.read(magic, sizeof(magic)) or
+           not std::equal(magic, magic + sizeof(magic), state_magic)){
+            throw TimeSeries::SerializationError;
+        }
+        if(read_pod<uint32_t>(in) != state_version){
+            throw TimeSeries::SerializationError;
+        }
+        //refuse to reinterpret e.g. a float state as double
+        auto width = read_pod<uint8_t>(in);
+        auto is_float = read_pod<uint8_t>(in);
+        if(width != sizeof(T) or is_float != std::is_floating_point<T>::value){
+            throw TimeSeries::SerializationError;
+        }
+
+        ModelState<T> state;
+        state.fingerprint.length = read_pod<uint64_t>(in);
+        state.fingerprint.hash = read_pod<uint64_t>(in);
+
+        auto& output = state.output;
+        output.status = static_cast<TimeSeries::TSError>(read_pod<int32_t>(in));
+        output.params = read_array<T>(in);
+        std::get<0>(output.outs) = read_array<T>(in);
+        std::get<1>(output.outs).first = read_order(in);
+        std::get<1>(output.outs).second = read_order(in);
+        std::get<2>(output.outs) = read_vec<T>(in);
+        state.obs_tail = read_vec<T>(in);
+        state.resid_count = read_pod<uint64_t>(in);
+        state.resid_sse = read_pod<accumulator_t<T>>(in);
+        
+        //a state longer than the filter needs is not one this version wrote
+        auto [lags, d] = filter_lags(output);
+        if(std::get<2>(output.outs).size() > static_cast<Eigen::Index>(lags) or
+           state.obs_tail.size() > static_cast<Eigen::Index>(lags + d)){
+            throw TimeSeries::SerializationError;
+        }
+        return state;
+    }
+
+
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                        ModelCache
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    ModelCache::ModelCache(std::string directory) : dir(std::move(directory))
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if(ec){
+            throw TimeSeries::SerializationError;
+        }
+    }
+
+    std::string ModelCache::path_for(const std::string& series_id) const
+    {
+        /* ids may contain characters that are not valid in file names,
+         so keep the safe ones for readability and append a hash of
+         the full id to keep distinct ids distinct */
+        std::string name;
+        SeriesFingerprint fp;
+        for(char c : series_id){
+            fp.update(c);
+            bool safe = std::isalnum(static_cast<unsigned char>(c)) or
+                        c == '-' or c == '_' or c == '.';
+            name += safe ? c : '_';
+        }
+        char suffix[17];
+        std::snprintf(suffix, sizeof(suffix), "%016llx",
+                      static_cast<unsigned long long>(fp.hash));
+        return (std::filesystem::path(dir) / (name + "-" + suffix + ".tsm")).string();
+    }
+
+    template<typename T>
+    void ModelCache::store(const std::string& series_id, const ModelState<T>& state) const
+    {
+        auto path = path_for(series_id);
+        auto tmp = path + ".tmp";
+        std::error_code ec;
+        try {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if(not out){
+                throw TimeSeries::SerializationError;
+            }
+            write_state(out, state);
+        } catch(...) {
+            //the stream is closed by now, so the partial file can go
+            std::filesystem::remove(tmp, ec);
+            throw;
+        }
+        std::filesystem::rename(tmp, path, ec);
+        if(ec){
+            std::filesystem::remove(tmp, ec);
+            throw TimeSeries::SerializationError;
+        }
+    }
+
+    template<typename T>
+    std::optional<ModelState<T>> ModelCache::load(const std::string& series_id) const
+    {
+        std::ifstream in(path_for(series_id), std::ios::binary);
+        if(not in){
+            return std::nullopt;
+        }
+        try {
+            return read_state<T>(in);
+        } catch(TimeSeries::TSError) {
+            //a stale or corrupt entry is treated as a miss
+            return std::nullopt;
+        } catch(const std::exception&) {
+            //e.g. bad_alloc from a corrupt length on a stream that cannot seek
+            return std::nullopt;
+        }
+    }
+
+    template<typename T>
+    std::optional<ModelState<T>>
+    ModelCache::lookup(const std::string& series_id, const Vec<T>& series) const
+    {
+        auto state = load<T>(series_id);
+        if(not state or state->fingerprint.length > static_cast<uint64_t>(series.size())){
+            return std::nullopt;
+        }
+        if(fingerprint(series, state->fingerprint.length) != state->fingerprint){
+            return std::nullopt;
+        }
+        return state;
+    }
+
+    void ModelCache::erase(const std::string& series_id) const
+    {
+        std::error_code ec;
+        std::filesystem::remove(path_for(series_id), ec);
+    }
+    
+    template void SeriesFingerprint::update(char x) noexcept;
+    template void SeriesFingerprint::update(float x) noexcept;
+    template void SeriesFingerprint::update(double x) noexcept;
+    
+    #define TS_INSTANTIATE_MODEL_STATE(T)                                                   \
+    template SeriesFingerprint fingerprint(const Vec<T>& series,                        \
+                                           std::optional<size_t> prefix);               \
+    template ModelState<T> make_state(const ARIMAOutput<T>& output,                     \
+                                      const Vec<T>& series);                            \
+    template ModelState<T> extend_state(const ModelState<T>& cached,                    \
+                                        const ARIMAOutput<T>& update,                   \
+                                        const Vec<T>& series);                          \
+    template void write_state(std::ostream& out, const ModelState<T>& state);           \
+    template ModelState<T> read_state<T>(std::istream& in);                             \
+    template void ModelCache::store(const std::string& series_id,                       \
+                                    const ModelState<T>& state) const;                  \
+    template std::optional<ModelState<T>>                                               \
+    ModelCache::load<T>(const std::string& series_id) const;                            \
+    template std::optional<ModelState<T>>                                               \
+    ModelCache::lookup(const std::string& series_id, const Vec<T>& series) const;
+    
+    TS_INSTANTIATE_MODEL_STATE(float)
+    TS_INSTANTIATE_MODEL_STATE(double)
+    
+    #undef TS_INSTANTIATE_MODEL_STATE
+}
@@ -22,8 +22,19 @@ namespace TimeSeries
             throw TimeSeries::NonArithmeticTypeError;
         }
         
-        auto beta = X.colPivHouseholderQr().solve(y);
+        typedef accumulator_t<T> acc;
+        Vec<acc> beta = X.template cast<acc>().colPivHouseholderQr()
+                            .solve(y.template cast<acc>());
         
-        return beta;
+        std::vector<T> coefs(beta.size());
+        for(Eigen::Index i = 0; i < beta.size(); i++){
+            coefs[i] = static_cast<T>(beta[i]);
+        }
+        return coefs;
     }
+    
+    template Mat<float>  ols_model_matrix(Mat<float>& X);
+    template Mat<double> ols_model_matrix(Mat<double>& X);
+    template std::vector<float>  ols_fit(Vec<float>& y, Mat<float>& X);
+    template std::vector<double> ols_fit(Vec<double>& y, Mat<double>& X);
 }
@@ -0,0 +1,661 @@
+/**
+ @author: agent
+ @brief: implementation of rolling.hpp
+ */
+#include "../include/rolling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace TimeSeries
+{
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                    WindowQuantile
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    template<typename T>
+    void WindowQuantile<T>::rebalance()
+    {
+        auto n = size();
+        if(n == 0){
+            return;
+        }
+        //lo holds the floor(q * (n-1)) + 1 smallest elements
+        auto target = static_cast<size_t>(q * (n - 1)) + 1;
+        while(lo.size() > target){
+            auto it = std::prev(lo.end());
+            hi.insert(*it);
+            lo.erase(it);
+        }
+        while(lo.size() < target){
+            auto it = hi.begin();
+            lo.insert(*it);
+            hi.erase(it);
+        }
+    }
+
+    template<typename T>
+    void WindowQuantile<T>::insert(T x)
+    {
+        if(lo.empty() or x <= *lo.rbegin()){
+            lo.insert(x);
+        } else {
+            hi.insert(x);
+        }
+        rebalance();
+    }
+
+    template<typename T>
+    void WindowQuantile<T>::erase(T x)
+    {
+        /* every element of hi is >= max(lo), so if x <= max(lo)
+         a copy of x is guaranteed to be in lo */
+        auto& side = (not lo.empty() and x <= *lo.rbegin()) ? lo : hi;
+        auto it = side.find(x);
+        //x was never inserted (e.g. NaN, which has no place in the order)
+        if(it == side.end()){
+            return;
+        }
+        side.erase(it);
+        rebalance();
+    }
+
+    template<typename T>
+    double WindowQuantile<T>::value() const
+    {
+        auto n = size();
+        if(n == 0){
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        double pos = q * (n - 1);
+        double frac = pos - std::floor(pos);
+        double lower = static_cast<double>(*lo.rbegin());
+        if(frac > 0 and not hi.empty()){
+            return lower + frac * (static_cast<double>(*hi.begin()) - lower);
+        }
+        return lower;
+    }
+
+
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                        Rolling
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    /* a window's moments are rebuilt from its data once its m2 falls below
+     this fraction of its peak since the last rebuild, which bounds the
+     relative error of the variance by about eps / rolling_rebuild_ratio */
+    constexpr double rolling_rebuild_ratio = 1e-4;
+
+    template<typename Series_t, typename DateTime_t>
+    Rolling<Series_t, DateTime_t>::Rolling(const Vec<Series_t>& _data,
+                                           std::vector<size_t> _windows)
+    : data(_data), windows(std::move(_windows))
+    {
+        if(windows.empty()){
+            throw TimeSeries::InvalidWindowError;
+        }
+        for(auto w : windows){
+            if(w == 0){
+                throw TimeSeries::InvalidWindowError;
+            }
+        }
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Rolling<Series_t, DateTime_t>::Rolling(const Vec<Series_t>& _data,
+                                           std::vector<DateTime_t> _times,
+                                           std::vector<duration_type> _spans)
+    : data(_data), times(std::move(_times)), spans(std::move(_spans))
+    {
+        if(spans->empty()){
+            throw TimeSeries::InvalidWindowError;
+        }
+        for(const auto& span : *spans){
+            if(span.is_special() or span.is_negative() or span == duration_type()){
+                throw TimeSeries::InvalidWindowError;
+            }
+        }
+        //the two-pointer sweep needs one sorted label per observation
+        if(times.size() != static_cast<size_t>(data.size()) or
+           not std::is_sorted(times.begin(), times.end())){
+            throw TimeSeries::InvalidParameterError;
+        }
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Rolling<Series_t, DateTime_t>::Rolling(const ts<Series_t, DateTime_t>& series,
+                                           std::vector<size_t> _windows)
+    : Rolling(series.getData(), std::move(_windows))
+    {}
+
+    template<typename Series_t, typename DateTime_t>
+    Rolling<Series_t, DateTime_t>::Rolling(const ts<Series_t, DateTime_t>& series,
+                                           std::vector<duration_type> _spans)
+    : Rolling(series.getData(), labels_of(series), std::move(_spans))
+    {}
+
+    template<typename Series_t, typename DateTime_t>
+    std::vector<DateTime_t>
+    Rolling<Series_t, DateTime_t>::labels_of(const ts<Series_t, DateTime_t>& series)
+    {
+        auto labels = series.getTimes();
+        if(not labels){
+            throw TimeSeries::MissingTimeLabelsError;
+        }
+        //DateVec is ordered, so the labels come out sorted
+        return std::vector<DateTime_t>(labels->begin(), labels->end());
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    size_t Rolling<Series_t, DateTime_t>::num_windows() const noexcept
+    {
+        return spans ? spans->size() : windows.size();
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    size_t Rolling<Series_t, DateTime_t>::window_start(size_t k,
+                                                       size_t i,
+                                                       size_t prev) const
+    {
+        if(not spans){
+            return (i + 1 >= windows[k]) ? i + 1 - windows[k] : 0;
+        }
+        //window starts only ever move forward, so this is O(1) amortized
+        auto earliest = times[i] - (*spans)[k];
+        while(prev < i and times[prev] <= earliest){
+            prev++;
+        }
+        return prev;
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    bool Rolling<Series_t, DateTime_t>::window_full(size_t k, size_t i) const
+    {
+        return spans or i + 1 >= windows[k];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    std::vector<Mat<result_t<Series_t>>>
+    Rolling<Series_t, DateTime_t>::compute(const std::vector<RollingStat>& stats,
+                                           double quantile)
+    const
+    {
+        if(quantile < 0 or quantile > 1){
+            throw TimeSeries::InvalidParameterError;
+        }
+        const auto nan = std::numeric_limits<result_t<Series_t>>::quiet_NaN();
+        const size_t n = data.size();
+        const size_t nw = num_windows();
+
+        bool need_min = false, need_max = false, need_quant = false;
+        for(auto s : stats){
+            need_min   |= (s == RollingStat::Min);
+            need_max   |= (s == RollingStat::Max);
+            need_quant |= (s == RollingStat::Quantile);
+        }
+
+        typedef Mat<result_t<Series_t>> out_type;
+        std::vector<out_type> out(stats.size(), out_type::Constant(n, nw, nan));
+        if(n == 0){
+            return out;
+        }
+
+        /* moments use Welford add/remove per window. Removal cancels what
+         the leaving observation added, so once the window's sum of
+         squared deviations m2 drops far below the largest value it has had
+         since the last rebuild (a spike or level shift has left the
+         window), the rounding error left in m2 would dominate it; the
+         window's mean and m2 are then recomputed from the window itself.
+         Each window's mean is held as anchor + mean, with the running mean
+         folded into the anchor after every update, so deviations are taken
+         from a nearby representable value and the mean keeps the digits
+         that rounding it at the series' level would lose.
+         Non-finite observations are never fed to the kernels; they only
+         occupy their slot in the window */
+        std::vector<size_t>     start(nw, 0);
+        std::vector<acc_type>   count(nw, 0);
+        std::vector<acc_type>   anchor(nw, 0), mean(nw, 0), m2(nw, 0), peak(nw, 0);
+        std::vector<char>       full(nw);
+
+        std::vector<MonotonicDeque<Series_t, std::less<Series_t>>>    mins(need_min ? nw : 0);
+        std::vector<MonotonicDeque<Series_t, std::greater<Series_t>>> maxes(need_max ? nw : 0);
+        std::vector<WindowQuantile<Series_t>> quants(need_quant ? nw : 0,
+                                                     WindowQuantile<Series_t>(quantile));
+
+        for(size_t i = 0; i < n; i++){
+            const Series_t xs = data[i];
+            const acc_type x = static_cast<acc_type>(xs);
+            const bool finite = std::isfinite(x);
+
+            //remove what leaves each window; at most one observation for count windows
+            for(size_t k = 0; k < nw; k++){
+                auto s = window_start(k, i, start[k]);
+                for(auto j = start[k]; j < s; j++){
+                    const acc_type y = static_cast<acc_type>(data[j]);
+                    if(not std::isfinite(y)){
+                        continue;
+                    }
+                    count[k] -= 1;
+                    if(count[k] == 0){
+                        anchor[k] = 0;
+                        mean[k] = 0;
+                        m2[k] = 0;
+                    } else {
+                        const acc_type dy = y - anchor[k];
+                        const acc_type delta = dy - mean[k];
+                        mean[k] -= delta / count[k];
+                        m2[k] -= delta * (dy - mean[k]);
+                        const acc_type a = anchor[k] + mean[k];
+                        mean[k] -= a - anchor[k];
+                        anchor[k] = a;
+                    }
+                    if(need_quant){
+                        quants[k].erase(data[j]);
+                    }
+                }
+                start[k] = s;
+                full[k] = window_full(k, i);
+            }
+
+            //x enters every window; the same arithmetic for all k, so this vectorizes
+            if(finite){
+                for(size_t k = 0; k < nw; k++){
+                    const acc_type dx = x - anchor[k];
+                    count[k] += 1;
+                    const acc_type delta = dx - mean[k];
+                    mean[k] += delta / count[k];
+                    m2[k] += delta * (dx - mean[k]);
+                    //a - anchor is exact, so anchor + mean is unchanged
+                    const acc_type a = anchor[k] + mean[k];
+                    mean[k] -= a - anchor[k];
+                    anchor[k] = a;
+                }
+            }
+
+            for(size_t k = 0; k < nw; k++){
+                if(m2[k] >= rolling_rebuild_ratio * peak[k]){
+                    peak[k] = std::max(peak[k], m2[k]);
+                    continue;
+                }
+                /* two-pass mean and m2 over the window's finite observations;
+                 the first pass's mean is rounded at the series' level, so
+                 its residual is kept in mean[k] by a correction pass */
+                acc_type cnt = 0, sum = 0;
+                for(size_t j = start[k]; j <= i; j++){
+                    const acc_type y = static_cast<acc_type>(data[j]);
+                    if(std::isfinite(y)){
+                        cnt += 1;
+                        sum += y;
+                    }
+                }
+                const acc_type mu = (cnt > 0) ? sum / cnt : 0;
+                acc_type resid = 0;
+                for(size_t j = start[k]; j <= i; j++){
+                    const acc_type y = static_cast<acc_type>(data[j]);
+                    if(std::isfinite(y)){
+                        resid += y - mu;
+                    }
+                }
+                resid = (cnt > 0) ? resid / cnt : 0;
+                acc_type ss = 0;
+                for(size_t j = start[k]; j <= i; j++){
+                    const acc_type y = static_cast<acc_type>(data[j]);
+                    if(std::isfinite(y)){
+                        ss += ((y - mu) - resid) * ((y - mu) - resid);
+                    }
+                }
+                count[k] = cnt;
+                anchor[k] = mu;
+                mean[k] = resid;
+                m2[k] = ss;
+                peak[k] = ss;
+            }
+
+            if(need_min or need_max or need_quant){
+                for(size_t k = 0; k < nw; k++){
+                    if(need_min){
+                        mins[k].expire(start[k]);
+                    }
+                    if(need_max){
+                        maxes[k].expire(start[k]);
+                    }
+                    if(not finite){
+                        continue;
+                    }
+                    if(need_min){
+                        mins[k].push(i, xs);
+                    }
+                    if(need_max){
+                        maxes[k].push(i, xs);
+                    }
+                    if(need_quant){
+                        quants[k].insert(xs);
+                    }
+                }
+            }
+
+            for(size_t s = 0; s < stats.size(); s++){
+                auto& o = out[s];
+                switch(stats[s]){
+                    case RollingStat::Mean:
+                        for(size_t k = 0; k < nw; k++){
+                            o(i, k) = (full[k] and count[k] > 0) ? anchor[k] + mean[k] : nan;
+                        }
+                        break;
+                    case RollingStat::Var:
+                        for(size_t k = 0; k < nw; k++){
+                            o(i, k) = (full[k] and count[k] > 1) ? std::max<acc_type>(m2[k], 0) / (count[k] - 1) : nan;
+                        }
+                        break;
+                    case RollingStat::SD:
+                        for(size_t k = 0; k < nw; k++){
+                            o(i, k) = (full[k] and count[k] > 1) ? std::sqrt(std::max<acc_type>(m2[k], 0) / (count[k] - 1)) : nan;
+                        }
+                        break;
+                    case RollingStat::ZScore:
+                        for(size_t k = 0; k < nw; k++){
+                            bool ok = full[k] and count[k] > 1 and m2[k] > 0;
+                            o(i, k) = ok ? ((x - anchor[k]) - mean[k]) / std::sqrt(m2[k] / (count[k] - 1)) : nan;
+                        }
+                        break;
+                    case RollingStat::Min:
+                        for(size_t k = 0; k < nw; k++){
+                            o(i, k) = (full[k] and not mins[k].empty()) ? mins[k].front() : nan;
+                        }
+                        break;
+                    case RollingStat::Max:
+                        for(size_t k = 0; k < nw; k++){
+                            o(i, k) = (full[k] and not maxes[k].empty()) ? maxes[k].front() : nan;
+                        }
+                        break;
+                    case RollingStat::Quantile:
+                        for(size_t k = 0; k < nw; k++){
+                            o(i, k) = full[k] ? quants[k].value() : nan;
+                        }
+                        break;
+                }
+            }//end for stats
+        }//end sweep
+        return out;
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> Rolling<Series_t, DateTime_t>::mean() const
+    {
+        return compute({RollingStat::Mean})[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> Rolling<Series_t, DateTime_t>::var() const
+    {
+        return compute({RollingStat::Var})[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> Rolling<Series_t, DateTime_t>::sd() const
+    {
+        return compute({RollingStat::SD})[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> Rolling<Series_t, DateTime_t>::zscore() const
+    {
+        return compute({RollingStat::ZScore})[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> Rolling<Series_t, DateTime_t>::min() const
+    {
+        return compute({RollingStat::Min})[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> Rolling<Series_t, DateTime_t>::max() const
+    {
+        return compute({RollingStat::Max})[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> Rolling<Series_t, DateTime_t>::median() const
+    {
+        return compute({RollingStat::Quantile}, 0.5)[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> Rolling<Series_t, DateTime_t>::quantile(double q) const
+    {
+        return compute({RollingStat::Quantile}, q)[0];
+    }
+
+
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                        EWM
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    template<typename Series_t, typename DateTime_t>
+    EWM<Series_t, DateTime_t>::EWM(const ts<Series_t, DateTime_t>& series,
+                                   std::vector<double> _alphas)
+    : EWM(series.getData(), std::move(_alphas))
+    {}
+
+    template<typename Series_t, typename DateTime_t>
+    EWM<Series_t, DateTime_t>::EWM(const Vec<Series_t>& _data,
+                                   std::vector<double> _alphas)
+    : data(_data), alphas(std::move(_alphas))
+    {
+        if(alphas.empty()){
+            throw TimeSeries::InvalidParameterError;
+        }
+        for(auto a : alphas){
+            if(not (a > 0 and a <= 1)){
+                throw TimeSeries::InvalidParameterError;
+            }
+        }
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    std::vector<Mat<result_t<Series_t>>>
+    EWM<Series_t, DateTime_t>::compute(const std::vector<RollingStat>& stats)
+    const
+    {
+        const auto nan = std::numeric_limits<result_t<Series_t>>::quiet_NaN();
+        const size_t n = data.size();
+        const size_t na = alphas.size();
+
+        for(auto s : stats){
+            if(s != RollingStat::Mean and s != RollingStat::Var and
+               s != RollingStat::SD and s != RollingStat::ZScore){
+                throw TimeSeries::InvalidParameterError;
+            }
+        }
+
+        typedef Mat<result_t<Series_t>> out_type;
+        std::vector<out_type> out(stats.size(), out_type::Constant(n, na, nan));
+        if(n == 0){
+            return out;
+        }
+
+        std::vector<acc_type> mean(na, 0);
+        std::vector<acc_type> var(na, 0);
+        //rows before the first finite observation stay NaN
+        bool seeded = false;
+
+        for(size_t i = 0; i < n; i++){
+            const acc_type x = static_cast<acc_type>(data[i]);
+            //non-finite observations leave the state as it was
+            if(std::isfinite(x)){
+                if(not seeded){
+                    std::fill(mean.begin(), mean.end(), x);
+                    seeded = true;
+                } else {
+                    for(size_t k = 0; k < na; k++){
+                        acc_type diff = x - mean[k];
+                        acc_type incr = alphas[k] * diff;
+                        mean[k] += incr;
+                        var[k] = (1 - alphas[k]) * (var[k] + diff * incr);
+                    }
+                }
+            }
+            if(not seeded){
+                continue;
+            }
+            for(size_t s = 0; s < stats.size(); s++){
+                auto& o = out[s];
+                switch(stats[s]){
+                    case RollingStat::Mean:
+                        for(size_t k = 0; k < na; k++){
+                            o(i, k) = mean[k];
+                        }
+                        break;
+                    case RollingStat::Var:
+                        for(size_t k = 0; k < na; k++){
+                            o(i, k) = var[k];
+                        }
+                        break;
+                    case RollingStat::SD:
+                        for(size_t k = 0; k < na; k++){
+                            o(i, k) = std::sqrt(var[k]);
+                        }
+                        break;
+                    case RollingStat::ZScore:
+                        for(size_t k = 0; k < na; k++){
+                            o(i, k) = (var[k] > 0) ? (x - mean[k]) / std::sqrt(var[k]) : nan;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+        return out;
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> EWM<Series_t, DateTime_t>::mean() const
+    {
+        return compute({RollingStat::Mean})[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> EWM<Series_t, DateTime_t>::var() const
+    {
+        return compute({RollingStat::Var})[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> EWM<Series_t, DateTime_t>::sd() const
+    {
+        return compute({RollingStat::SD})[0];
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Mat<result_t<Series_t>> EWM<Series_t, DateTime_t>::zscore() const
+    {
+        return compute({RollingStat::ZScore})[0];
+    }
+
+
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                ts::rolling and ts::ewm
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    template<typename Series_t, typename DateTime_t>
+    Rolling<Series_t, DateTime_t>
+    ts<Series_t, DateTime_t>::rolling(size_t window) const
+    {
+        return Rolling<Series_t, DateTime_t>(*this, std::vector<size_t>{window});
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Rolling<Series_t, DateTime_t>
+    ts<Series_t, DateTime_t>::rolling(std::vector<size_t> windows) const
+    {
+        return Rolling<Series_t, DateTime_t>(*this, std::move(windows));
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Rolling<Series_t, DateTime_t>
+    ts<Series_t, DateTime_t>::rolling(typename DateTime_t::duration_type span) const
+    {
+        using duration_type = typename DateTime_t::duration_type;
+        return Rolling<Series_t, DateTime_t>(*this, std::vector<duration_type>{span});
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    Rolling<Series_t, DateTime_t>
+    ts<Series_t, DateTime_t>::rolling(std::vector<typename DateTime_t::duration_type> spans)
+    const
+    {
+        return Rolling<Series_t, DateTime_t>(*this, std::move(spans));
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    EWM<Series_t, DateTime_t>
+    ts<Series_t, DateTime_t>::ewm(double alpha) const
+    {
+        return EWM<Series_t, DateTime_t>(*this, std::vector<double>{alpha});
+    }
+
+    template<typename Series_t, typename DateTime_t>
+    EWM<Series_t, DateTime_t>
+    ts<Series_t, DateTime_t>::ewm(std::vector<double> alphas) const
+    {
+        return EWM<Series_t, DateTime_t>(*this, std::move(alphas));
+    }
+
+
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                explicit instantiations
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    #define TS_INSTANTIATE_ROLLING(T)                                                   \
+    template class WindowQuantile<T>;                                                   \
+    template Rolling<T>::Rolling(const ts<T>&, std::vector<size_t>);                    \
+    template Rolling<T>::Rolling(const ts<T>&,                                          \
+                                 std::vector<boost::gregorian::date_duration>);         \
+    template Rolling<T>::Rolling(const Vec<T>&, std::vector<size_t>);                   \
+    template Rolling<T>::Rolling(const Vec<T>&,                                         \
+                                 std::vector<boost::gregorian::date>,                   \
+                                 std::vector<boost::gregorian::date_duration>);         \
+    template size_t Rolling<T>::num_windows() const noexcept;                           \
+    template std::vector<Mat<result_t<T>>>                                              \
+    Rolling<T>::compute(const std::vector<RollingStat>&, double) const;                 \
+    template Mat<result_t<T>> Rolling<T>::mean() const;                                 \
+    template Mat<result_t<T>> Rolling<T>::var() const;                                  \
+    template Mat<result_t<T>> Rolling<T>::sd() const;                                   \
+    template Mat<result_t<T>> Rolling<T>::zscore() const;                               \
+    template Mat<result_t<T>> Rolling<T>::min() const;                                  \
+    template Mat<result_t<T>> Rolling<T>::max() const;                                  \
+    template Mat<result_t<T>> Rolling<T>::median() const;                               \
+    template Mat<result_t<T>> Rolling<T>::quantile(double) const;                       \
+    template EWM<T>::EWM(const ts<T>&, std::vector<double>);                            \
+    template EWM<T>::EWM(const Vec<T>&, std::vector<double>);                           \
+    template std::vector<Mat<result_t<T>>>                                              \
+    EWM<T>::compute(const std::vector<RollingStat>&) const;                             \
+    template Mat<result_t<T>> EWM<T>::mean() const;                                     \
+    template Mat<result_t<T>> EWM<T>::var() const;                                      \
+    template Mat<result_t<T>> EWM<T>::sd() const;                                       \
+    template Mat<result_t<T>> EWM<T>::zscore() const;                                   \
+    template Rolling<T> ts<T>::rolling(size_t) const;                                   \
+    template Rolling<T> ts<T>::rolling(std::vector<size_t>) const;                      \
+    template Rolling<T> ts<T>::rolling(boost::gregorian::date_duration) const;          \
+    template Rolling<T>                                                                 \
+    ts<T>::rolling(std::vector<boost::gregorian::date_duration>) const;                 \
+    template EWM<T> ts<T>::ewm(double) const;                                           \
+    template EWM<T> ts<T>::ewm(std::vector<double>) const;
+
+    TS_INSTANTIATE_ROLLING(float)
+    TS_INSTANTIATE_ROLLING(double)
+
+    #undef TS_INSTANTIATE_ROLLING
+}
@@ -0,0 +1,468 @@
+/**
+ @author: agent
+ @brief: implementation of scheduler.hpp
+ */
+#include "../include/scheduler.hpp"
+#include "../include/ts_error.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#ifdef TS_USE_NUMA
+    #include <numa.h>
+#endif
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#ifdef TS_USE_MKL
+    #include <mkl.h>
+#endif
+
+namespace TimeSeries
+{
+    namespace
+    {
+        //id of the worker running on this thread, if any
+        thread_local std::optional<size_t> tl_worker;
+        
+        //longest a worker waiting on a group sleeps before looking for queued tasks
+        constexpr auto helper_poll = std::chrono::milliseconds(1);
+
+        struct Cpu
+        {
+            int     id;
+            size_t  node;
+        };
+
+        /**
+         @author: agent
+         @return: CPUs this process may run on, ordered by NUMA node, with
+         nodes renumbered from 0. Empty if the CPUs cannot be determined,
+         in which case workers are not pinned
+         */
+        std::vector<Cpu> cpu_layout()
+        {
+            std::vector<Cpu> cpus;
+        #ifdef __linux__
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+                return cpus;
+            }
+            #ifdef TS_USE_NUMA
+            if(numa_available() >= 0){
+                struct bitmask* mask = numa_allocate_cpumask();
+                size_t node = 0;
+                for(int n = 0; n <= numa_max_node(); n++){
+                    if(numa_node_to_cpus(n, mask) != 0){
+                        continue;
+                    }
+                    bool used = false;
+                    for(unsigned c = 0; c < mask->size and c < CPU_SETSIZE; c++){
+                        if(numa_bitmask_isbitset(mask, c) and CPU_ISSET(c, &allowed)){
+                            cpus.push_back({static_cast<int>(c), node});
+                            used = true;
+                        }
+                    }
+                    node += used;
+                }
+                numa_free_cpumask(mask);
+            }
+            #endif
+            if(cpus.empty()){
+                for(int c = 0; c < CPU_SETSIZE; c++){
+                    if(CPU_ISSET(c, &allowed)){
+                        cpus.push_back({c, 0});
+                    }
+                }
+            }
+        #endif
+            return cpus;
+        }
+
+        size_t default_num_threads()
+        {
+            if(const char* env = std::getenv("TS_NUM_THREADS")){
+                auto n = std::strtoul(env, nullptr, 10);
+                if(n > 0){
+                    return n;
+                }
+            }
+            //one worker per CPU this process may run on
+            auto cpus = cpu_layout();
+            if(not cpus.empty()){
+                return cpus.size();
+            }
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        //workers are pinned unless TS_PIN_THREADS is 0
+        bool default_pinning()
+        {
+            const char* env = std::getenv("TS_PIN_THREADS");
+            return not env or std::strtoul(env, nullptr, 10) != 0;
+        }
+    }
+
+
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                    SerialBackendGuard
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    SerialBackendGuard::SerialBackendGuard()
+    {
+        /* Eigen::setNbThreads is process-wide, so it is left alone; Eigen's
+         OpenMP path follows omp_get_max_threads, which is per thread */
+    #ifdef _OPENMP
+        omp_threads = omp_get_max_threads();
+        omp_set_num_threads(1);
+    #endif
+    #ifdef TS_USE_MKL
+        mkl_threads = mkl_set_num_threads_local(1);
+    #endif
+    }
+
+    SerialBackendGuard::~SerialBackendGuard()
+    {
+    #ifdef _OPENMP
+        omp_set_num_threads(omp_threads);
+    #endif
+    #ifdef TS_USE_MKL
+        //0 hands the thread back to MKL's global setting
+        mkl_set_num_threads_local(mkl_threads);
+    #endif
+    }
+
+
+    /* ---------------------------------------------------------------------------------
+     ---------------------------------------------------------------------------------
+                                        Scheduler
+     ---------------------------------------------------------------------------------
+     --------------------------------------------------------------------------------- */
+
+    Scheduler::Scheduler() : pinning(default_pinning())
+    {
+        start(default_num_threads());
+    }
+
+    Scheduler::~Scheduler()
+    {
+        stop();
+    }
+
+    Scheduler& Scheduler::instance()
+    {
+        static Scheduler scheduler;
+        return scheduler;
+    }
+
+    void Scheduler::start(size_t nThreads)
+    {
+        stopping = false;
+        auto cpus = cpu_layout();
+
+        /* spread workers evenly over the node-ordered CPU list, so
+         consecutive workers share a node and every node gets its share */
+        workers.clear();
+        nodes = 1;
+        for(size_t i = 0; i < nThreads; i++){
+            auto w = std::make_unique<Worker>();
+            if(not cpus.empty()){
+                size_t c = (nThreads <= cpus.size()) ? i * cpus.size() / nThreads
+                                                     : i % cpus.size();
+                if(pinning){
+                    w->cpu = cpus[c].id;
+                }
+                w->node = cpus[c].node;
+                nodes = std::max(nodes, w->node + 1);
+            }
+            workers.push_back(std::move(w));
+        }
+        //every worker must exist before any of them tries to steal
+        for(size_t i = 0; i < nThreads; i++){
+            workers[i]->thread = std::thread(&Scheduler::worker_loop, this, i);
+        }
+    }
+
+    void Scheduler::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for(auto& w : workers){
+            if(w->thread.joinable()){
+                w->thread.join();
+            }
+        }
+        workers.clear();
+    }
+
+    void Scheduler::worker_loop(size_t id)
+    {
+        tl_worker = id;
+        auto& self = *workers[id];
+    #ifdef __linux__
+        if(self.cpu){
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(*self.cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+    #endif
+    #ifdef TS_USE_NUMA
+        //allocations made by tasks land on this worker's node
+        numa_set_localalloc();
+    #endif
+        while(true){
+            if(run_one(id)){
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            wakeup.wait(lock, [this]{ return stopping or queued > 0; });
+            //queued tasks are drained before the pool shuts down
+            if(stopping and queued == 0){
+                return;
+            }
+        }
+    }
+
+    bool Scheduler::run_one(size_t self)
+    {
+        std::optional<Task> task;
+        {
+            auto& w = *workers[self];
+            std::lock_guard<std::mutex> lock(w.mutex);
+            if(not w.tasks.empty()){
+                task = std::move(w.tasks.back());
+                w.tasks.pop_back();
+            }
+        }
+        if(not task){
+            task = steal(self);
+        }
+        if(not task){
+            return false;
+        }
+        queued--;
+        execute(*task);
+        return true;
+    }
+
+    std::optional<Scheduler::Task> Scheduler::steal(size_t self)
+    {
+        const size_t n = workers.size();
+        //pass 0 only visits self's node, pass 1 the rest
+        for(int pass = 0; pass < 2; pass++){
+            for(size_t j = 1; j < n; j++){
+                size_t victim = (self + j) % n;
+                bool local = workers[victim]->node == workers[self]->node;
+                if((pass == 0) != local){
+                    continue;
+                }
+                auto& w = *workers[victim];
+                std::lock_guard<std::mutex> lock(w.mutex);
+                if(not w.tasks.empty()){
+                    Task task = std::move(w.tasks.front());
+                    w.tasks.pop_front();
+                    return task;
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    void Scheduler::execute(Task& task)
+    {
+        auto* group = task.group;
+        try {
+            if(serial_backends){
+                SerialBackendGuard guard;
+                task.fn();
+            } else {
+                task.fn();
+            }
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(group->error_mutex);
+            if(not group->error){
+                group->error = std::current_exception();
+            }
+        }
+        /* the waiter may destroy the group as soon as it sees zero, so the
+         last decrement and the signal both happen under done_mutex, which
+         the waiter takes before returning */
+        std::lock_guard<std::mutex> lock(group->done_mutex);
+        if(--group->remaining == 0){
+            group->done.notify_all();
+        }
+    }
+
+    void Scheduler::set_num_threads(size_t nThreads)
+    {
+        if(nThreads == 0 or tl_worker){
+            throw TimeSeries::InvalidParameterError;
+        }
+        stop();
+        start(nThreads);
+    }
+
+    size_t Scheduler::num_threads() const noexcept
+    {
+        return workers.size();
+    }
+
+    size_t Scheduler::num_nodes() const noexcept
+    {
+        return nodes;
+    }
+
+    size_t Scheduler::node_of(size_t id) const
+    {
+        return workers.at(id)->node;
+    }
+
+    void Scheduler::set_pinning(bool pin)
+    {
+        if(tl_worker){
+            throw TimeSeries::InvalidParameterError;
+        }
+        if(pin == pinning){
+            return;
+        }
+        pinning = pin;
+        size_t nThreads = workers.size();
+        stop();
+        start(nThreads);
+    }
+
+    bool Scheduler::pinned() const noexcept
+    {
+        return pinning;
+    }
+
+    void Scheduler::set_nested(bool allow) noexcept
+    {
+        nested = allow;
+    }
+
+    void Scheduler::set_serial_backends(bool force) noexcept
+    {
+        serial_backends = force;
+    }
+
+    std::optional<size_t> Scheduler::worker_id() noexcept
+    {
+        return tl_worker;
+    }
+
+    void Scheduler::run(TaskGroup& group,
+                        std::function<void()> fn,
+                        std::optional<size_t> worker)
+    {
+        size_t target;
+        if(worker){
+            target = *worker % workers.size();
+        } else if(tl_worker){
+            target = *tl_worker;
+        } else {
+            target = next_worker++ % workers.size();
+        }
+
+        group.remaining++;
+        {
+            /* counted before the push so a thief can never decrement first;
+             taking the lock orders it before any worker's sleep check */
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            queued++;
+        }
+        {
+            auto& w = *workers[target];
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.tasks.push_back(Task{std::move(fn), &group});
+        }
+        wakeup.notify_all();
+    }
+
+    void Scheduler::wait(TaskGroup& group)
+    {
+        if(tl_worker){
+            /* a worker helps with queued work instead of blocking, since
+             the tasks it waits on may be queued behind it. With nothing to
+             run it parks on the group, and looks again when work is queued
+             (which run does not signal here, hence the timeout) */
+            std::unique_lock<std::mutex> lock(group.done_mutex, std::defer_lock);
+            while(group.remaining > 0){
+                if(run_one(*tl_worker)){
+                    continue;
+                }
+                lock.lock();
+                group.done.wait_for(lock, helper_poll, [this, &group]{
+                    return group.remaining == 0 or queued > 0;
+                });
+                lock.unlock();
+            }
+        }
+        {
+            //also orders this return after the last task released done_mutex
+            std::unique_lock<std::mutex> lock(group.done_mutex);
+            group.done.wait(lock, [&group]{ return group.remaining == 0; });
+        }
+        if(group.error){
+            std::rethrow_exception(group.error);
+        }
+    }
+
+    void Scheduler::parallel_for(size_t begin,
+                                 size_t end,
+                                 size_t grain,
+                                 const std::function<void(size_t, size_t)>& body)
+    {
+        if(grain == 0){
+            throw TimeSeries::InvalidParameterError;
+        }
+        if(end <= begin){
+            return;
+        }
+        const size_t chunks = (end - begin + grain - 1) / grain;
+        const size_t nThreads = num_threads();
+        if(chunks == 1 or nThreads <= 1 or (tl_worker and not nested)){
+            body(begin, end);
+            return;
+        }
+
+        TaskGroup group;
+        for(size_t c = 0; c < chunks; c++){
+            size_t b = begin + c * grain;
+            size_t e = std::min(b + grain, end);
+            //chunk c always starts on the same worker, and so the same node
+            run(group, [&body, b, e]{ body(b, e); }, c * nThreads / chunks);
+        }
+        wait(group);
+    }
+
+
+    template<typename T>
+    Vec<T> first_touch_copy(const Vec<T>& src, size_t grain)
+    {
+        //Eigen leaves new storage uninitialized, so no page is touched before the copy
+        Vec<T> dst(src.size());
+        Scheduler::instance().parallel_for(0, src.size(), grain,
+            [&](size_t b, size_t e){
+                dst.segment(b, e - b) = src.segment(b, e - b);
+            });
+        return dst;
+    }
+
+    template Vec<float>  first_touch_copy(const Vec<float>& src, size_t grain);
+    template Vec<double> first_touch_copy(const Vec<double>& src, size_t grain);
+}
@@ -0,0 +1,246 @@
+/**
+ @author: agent
+ @brief: checks ModelState serialization and ARMA::fit(cache): write/read
+ round trips, corrupt and truncated input, that an update over new
+ observations matches ARMA_filter run over the whole series while the
+ cached state stays a fixed size, and that a warm refit lands on the
+ same estimates as a cold one. Build and run with `make check` in this
+ directory.
+ */
+#include "../include/arima.hpp"
+#include "../include/model_cache.hpp"
+#include "../include/ts_error.hpp"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace TimeSeries;
+
+namespace
+{
+    int failures = 0;
+
+    void report(const std::string& what, bool ok)
+    {
+        std::printf("%s %s\n", ok ? "PASS" : "FAIL", what.c_str());
+        failures += not ok;
+    }
+
+    //true if f throws SerializationError
+    template<typename F>
+    bool rejects(F f)
+    {
+        try {
+            f();
+        } catch(TimeSeries::TSError e) {
+            return e == TimeSeries::SerializationError;
+        } catch(...) {
+            return false;
+        }
+        return false;
+    }
+
+    template<typename T>
+    bool same_state(const ModelState<T>& a, const ModelState<T>& b)
+    {
+        return a.output.params == b.output.params and
+               a.output.status == b.output.status and
+               a.output.outs == b.output.outs and
+               a.obs_tail == b.obs_tail and
+               a.resid_count == b.resid_count and
+               a.resid_sse == b.resid_sse and
+               a.fingerprint == b.fingerprint;
+    }
+
+    //ARIMA(2,1,1) around 100: dx_t = 0.5 dx_{t-1} - 0.2 dx_{t-2} + e_t + 0.4 e_{t-1}
+    Vec<double> arima_series(Eigen::Index n)
+    {
+        std::mt19937 gen(20261019);
+        std::normal_distribution<double> eps(0, 1);
+        Vec<double> x(n);
+        double level = 100, d1 = 0, d2 = 0, e1 = 0;
+        for(Eigen::Index t = 0; t < n; t++){
+            double e = eps(gen);
+            double dx = 0.5 * d1 - 0.2 * d2 + e + 0.4 * e1;
+            level += dx;
+            x[t] = level;
+            d2 = d1;
+            d1 = dx;
+            e1 = e;
+        }
+        return x;
+    }
+
+    double max_rel_diff(const std::vector<double>& a, const std::vector<double>& b)
+    {
+        if(a.size() != b.size()){
+            return INFINITY;
+        }
+        double worst = 0;
+        for(size_t i = 0; i < a.size(); i++){
+            worst = std::max(worst, std::abs(a[i] - b[i]) / (1 + std::abs(b[i])));
+        }
+        return worst;
+    }
+}
+
+int main()
+{
+    namespace fs = std::filesystem;
+    const Vec<double> x = arima_series(400);
+    const Eigen::Index n0 = 300;
+    const std::vector<size_t> order = {2, 1, 1};
+
+    //round trip through write_state/read_state, in both precisions
+    Vec<double> full = x;
+    ARMA<ts<double>> model{ts<double>(full)};
+    model.fit(order);
+    auto state = model.state();
+    std::stringstream buf;
+    write_state(buf, state);
+    const std::string bytes = buf.str();
+    {
+        std::istringstream in(bytes);
+        report("double round trip", same_state(read_state<double>(in), state));
+
+        Vec<float> xf = x.cast<float>();
+        ARMA<ts<float>> fmodel{ts<float>(xf)};
+        fmodel.fit(order);
+        auto fstate = fmodel.state();
+        std::stringstream fbuf;
+        write_state(fbuf, fstate);
+        report("float round trip", same_state(read_state<float>(fbuf), fstate));
+    }
+
+    //corrupt input is rejected with SerializationError, never a crash or huge allocation
+    {
+        auto read = [](std::string b){
+            return [b]{
+                std::istringstream in(b);
+                read_state<double>(in);
+            };
+        };
+        std::string badMagic = bytes;
+        badMagic[0] = 'X';
+        //magic, version, width, is_float, fingerprint and status come before the params length
+        const size_t paramsLength = 4 + 4 + 1 + 1 + 8 + 8 + 4;
+        std::string hugeLength = bytes;
+        const uint64_t huge = uint64_t(1) << 60;
+        hugeLength.replace(paramsLength, sizeof(huge), reinterpret_cast<const char*>(&huge), sizeof(huge));
+        bool truncations = true;
+        for(size_t cut = 0; cut < bytes.size(); cut += 7){
+            truncations = truncations and rejects(read(bytes.substr(0, cut)));
+        }
+        report("bad magic rejected", rejects(read(badMagic)));
+        report("corrupt array length rejected", rejects(read(hugeLength)));
+        report("truncated states rejected", truncations);
+        report("precision mismatch rejected", rejects([&]{
+            std::istringstream in(bytes);
+            read_state<float>(in);
+        }));
+    }
+
+    const fs::path dir = fs::temp_directory_path() / ("ts_model_cache_test_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    ModelCache cache(dir.string());
+
+    //an unreadable cache entry is a miss
+    {
+        Vec<double> head = x.head(n0);
+        cache.store("corrupt", state);
+        for(auto& entry : fs::directory_iterator(dir)){
+            fs::resize_file(entry.path(), fs::file_size(entry.path()) / 2);
+        }
+        report("truncated cache entry is a miss",
+               not cache.load<double>("corrupt") and not cache.lookup<double>("corrupt", head));
+        cache.erase("corrupt");
+    }
+
+    //cold fit on a prefix, then an update over the new observations
+    Vec<double> head = x.head(n0);
+    ARMA<ts<double>> first{ts<double>(head)};
+    first.setOrder(order);
+    auto cold = first.fit(cache, "series");
+
+    ARMA<ts<double>> second{ts<double>(full)};
+    auto updated = second.fit(cache, "series");
+    {
+        //the cached mean and parameters, run over the whole differenced series
+        const auto& extra = std::get<0>(cold.outs);
+        Vec<double> dx = x.tail(x.size() - 1) - x.head(x.size() - 1);
+        Vec<double> z = dx.array() - extra[0];
+        Vec<double> e = Vec<double>::Zero(z.size());
+        ARMA_filter(cold.params, order[0], order[2], z, e, order[0]);
+
+        const auto& got = std::get<2>(updated.outs);
+        const Eigen::Index added = x.size() - n0;
+        double worst = (got.size() == added) ? (got - e.tail(added)).cwiseAbs().maxCoeff() : INFINITY;
+        double sigma2 = e.squaredNorm() / (z.size() - order[0]);
+        report("update matches ARMA_filter over the full series",
+               updated.params == cold.params and worst < 1e-12 and
+               std::abs(std::get<0>(updated.outs)[1] - sigma2) < 1e-12 * sigma2);
+
+        //the stored state does not grow with the series
+        auto stored = cache.load<double>("series");
+        report("cache keeps only the filter's tail",
+               stored and std::get<2>(stored->output.outs).size() == 2 and
+               stored->obs_tail.size() == 3 and
+               stored->resid_count == static_cast<uint64_t>(z.size() - order[0]) and
+               std::abs(stored->resid_sse - e.squaredNorm()) < 1e-12 * e.squaredNorm() and
+               stored->fingerprint == fingerprint(x));
+    }
+
+    //an unchanged series is served from the cache
+    {
+        ARMA<ts<double>> again{ts<double>(full)};
+        auto hit = again.fit(cache, "series");
+        report("unchanged series is a cache hit",
+               hit.params == updated.params and
+               std::get<0>(hit.outs) == std::get<0>(updated.outs) and
+               std::get<2>(hit.outs).size() == 0);
+    }
+
+    //a warm refit converges to the cold estimates at the cached order
+    {
+        Vec<double> longer = arima_series(600);
+        ARMA<ts<double>> warm{ts<double>(longer)};
+        auto refit = warm.fit(cache, "series", true);
+
+        ARMA<ts<double>> reference{ts<double>(longer)};
+        auto coldFull = reference.fit(order);
+        /* Gauss-Newton stops once the sum of squares improves by less than 1e-10
+         of itself, which pins the parameters down to about its square root */
+        double worst = max_rel_diff(refit.params, coldFull.params);
+        double s2 = std::get<0>(refit.outs)[1];
+        double s2Cold = std::get<0>(coldFull.outs)[1];
+        report("warm refit matches a cold fit",
+               std::get<1>(refit.outs).first == std::vector<size_t>({2, 1, 1, 0}) and
+               worst < 1e-4 and std::abs(s2 - s2Cold) < 1e-8 * s2Cold);
+    }
+
+    //a series that no longer extends the cached data is refit cold at the cached order
+    {
+        Vec<double> revised = arima_series(600);
+        revised[10] += 1;
+        ARMA<ts<double>> changed{ts<double>(revised)};
+        auto out = changed.fit(cache, "series");
+
+        ARMA<ts<double>> reference{ts<double>(revised)};
+        auto coldRevised = reference.fit(order);
+        report("prefix mismatch keeps the cached order",
+               std::get<1>(out.outs).first == std::vector<size_t>({2, 1, 1, 0}) and
+               out.params == coldRevised.params and
+               std::get<1>(cache.load<double>("series")->output.outs).first ==
+                   std::vector<size_t>({2, 1, 1, 0}));
+    }
+
+    fs::remove_all(dir);
+    std::printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,121 @@
+/**
+ @author: agent
+ @brief: float vs double accuracy harness. Each reference series is run
+ through ACF, pACF, ols_fit and Rolling/EWM once stored as double and once
+ stored as float, and the float results must stay within a tolerance of
+ the double ones. Build and run with `make check` in this directory.
+ */
+#include "../include/arima.hpp"
+#include "../include/model_fit.hpp"
+#include "../include/rolling.hpp"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace TimeSeries;
+
+namespace
+{
+    int failures = 0;
+
+    /**
+     @author: agent
+     @param what: name of the check, printed on failure
+     @param f: result computed from float storage
+     @param d: result computed from double storage
+     @param tol: largest allowed |f - d| / (1 + |d|); NaNs must match
+     */
+    template<typename A, typename B>
+    void check(const std::string& what, const A& f, const B& d, double tol)
+    {
+        double worst = 0;
+        bool nanMismatch = false;
+        for(Eigen::Index i = 0; i < d.size(); i++){
+            double fi = static_cast<double>(f(i));
+            double di = static_cast<double>(d(i));
+            if(std::isnan(fi) or std::isnan(di)){
+                nanMismatch |= (std::isnan(fi) != std::isnan(di));
+                continue;
+            }
+            worst = std::max(worst, std::abs(fi - di) / (1 + std::abs(di)));
+        }
+        bool ok = (f.size() == d.size()) and not nanMismatch and worst <= tol;
+        std::printf("%s %-36s max rel err %.3e (tol %.0e)\n",
+                    ok ? "PASS" : "FAIL", what.c_str(), worst, tol);
+        failures += not ok;
+    }
+
+    //reference series: AR(1), sine plus noise, random walk with drift
+    std::vector<std::pair<std::string, Vec<double>>> reference_series(Eigen::Index n)
+    {
+        std::mt19937 gen(20260101);
+        std::normal_distribution<double> eps(0, 1);
+        Vec<double> ar(n), wave(n), walk(n);
+        double a = 0, w = 1000;
+        for(Eigen::Index t = 0; t < n; t++){
+            a = 0.7 * a + eps(gen);
+            ar[t] = a;
+            wave[t] = 10 * std::sin(2 * M_PI * t / 50.0) + 0.5 * eps(gen);
+            w += 0.05 + eps(gen);
+            walk[t] = w;
+        }
+        return {{"ar1", ar}, {"sine", wave}, {"walk", walk}};
+    }
+}
+
+int main()
+{
+    const Eigen::Index n = 20000;
+    const size_t lags = 40;
+
+    for(auto& [name, xd] : reference_series(n)){
+        Vec<float> xf = xd.cast<float>();
+        //compare against double run on the same (float-rounded) data
+        Vec<double> xr = xf.cast<double>();
+
+        check(name + " ACF", ACF(xf, lags), ACF(xr, lags), 1e-5);
+        check(name + " pACF", pACF(xf, lags), pACF(xr, lags), 1e-4);
+
+        //regress x_t on (1, x_{t-1}, x_{t-2})
+        Mat<double> Xd(n - 2, 3);
+        Xd.col(0).setOnes();
+        Xd.col(1) = xr.segment(1, n - 2);
+        Xd.col(2) = xr.head(n - 2);
+        Vec<double> yd = xr.tail(n - 2);
+        Mat<float> Xf = Xd.cast<float>();
+        Vec<float> yf = yd.cast<float>();
+        auto bf = ols_fit(yf, Xf);
+        auto bd = ols_fit(yd, Xd);
+        check(name + " ols_fit",
+              Eigen::Map<Vec<float>>(bf.data(), bf.size()),
+              Eigen::Map<Vec<double>>(bd.data(), bd.size()), 1e-4);
+
+        std::vector<size_t> windows {5, 20, 250};
+        std::vector<RollingStat> stats {RollingStat::Mean, RollingStat::SD,
+                                        RollingStat::Min, RollingStat::Max,
+                                        RollingStat::Quantile};
+        auto rf = Rolling<float>(xf, windows).compute(stats, 0.5);
+        auto rd = Rolling<double>(xr, windows).compute(stats, 0.5);
+        const char* statNames[] = {"mean", "sd", "min", "max", "median"};
+        for(size_t s = 0; s < stats.size(); s++){
+            check(name + " rolling " + statNames[s],
+                  rf[s].reshaped(), rd[s].reshaped(), 1e-5);
+        }
+
+        auto ef = EWM<float>(xf, {0.05, 0.3}).compute({RollingStat::Mean, RollingStat::SD});
+        auto ed = EWM<double>(xr, {0.05, 0.3}).compute({RollingStat::Mean, RollingStat::SD});
+        check(name + " ewm mean", ef[0].reshaped(), ed[0].reshaped(), 1e-5);
+        check(name + " ewm sd", ef[1].reshaped(), ed[1].reshaped(), 1e-5);
+    }
+
+    //integral series are centered in double, so ACF matches the double result
+    Vec<int> xi(8);
+    xi << 1, 2, 3, 4, 4, 3, 2, 1;
+    check("int ACF", ACF(xi, 4), ACF(Vec<double>(xi.cast<double>()), 4), 1e-12);
+    check("int pACF", pACF(xi, 4), pACF(Vec<double>(xi.cast<double>()), 4), 1e-12);
+
+    std::printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
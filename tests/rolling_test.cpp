@@ -0,0 +1,270 @@
+/**
+ @author: agent
+ @brief: checks Rolling against a brute-force reference that recomputes
+ every statistic from scratch for every window, on series built to break
+ streaming updates: level shifts far from the first observation, a
+ single huge spike, NaN/inf observations and irregular time-based
+ windows. Build and run with `make check` in this directory.
+ */
+#include "../include/rolling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace TimeSeries;
+
+namespace
+{
+    int failures = 0;
+
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+
+    const std::vector<RollingStat> all_stats = {RollingStat::Mean, RollingStat::Var,
+                                                RollingStat::SD, RollingStat::ZScore,
+                                                RollingStat::Min, RollingStat::Max,
+                                                RollingStat::Quantile};
+
+    const char* stat_names[] = {"mean", "var", "sd", "zscore", "min", "max", "quantile"};
+
+    /**
+     @author: agent
+     @param x: observation the window ends at (for the z-score)
+     @param window: observations in the window, non-finite ones included
+     @param stat: statistic to compute
+     @param q: quantile for RollingStat::Quantile
+     @return: stat over the finite observations of window, computed
+     directly: two-pass variance in long double, sorted quantiles
+     */
+    double brute(double x, std::vector<double> window, RollingStat stat, double q)
+    {
+        window.erase(std::remove_if(window.begin(), window.end(),
+                                    [](double y){ return not std::isfinite(y); }),
+                     window.end());
+        const size_t n = window.size();
+        long double sum = 0;
+        for(double y : window){
+            sum += y;
+        }
+        long double mean = n ? sum / n : 0;
+        long double ss = 0;
+        for(double y : window){
+            ss += (y - mean) * (y - mean);
+        }
+        double var = (n > 1) ? static_cast<double>(ss / (n - 1)) : missing;
+        std::sort(window.begin(), window.end());
+
+        switch(stat){
+            case RollingStat::Mean:
+                return n ? static_cast<double>(mean) : missing;
+            case RollingStat::Var:
+                return var;
+            case RollingStat::SD:
+                return std::sqrt(var);
+            case RollingStat::ZScore:
+                return (n > 1 and var > 0) ? static_cast<double>((x - mean) / std::sqrt(var)) : missing;
+            case RollingStat::Min:
+                return n ? window.front() : missing;
+            case RollingStat::Max:
+                return n ? window.back() : missing;
+            case RollingStat::Quantile: {
+                if(n == 0){
+                    return missing;
+                }
+                double pos = q * (n - 1);
+                size_t lo = static_cast<size_t>(pos);
+                double frac = pos - lo;
+                return (lo + 1 < n) ? window[lo] + frac * (window[lo + 1] - window[lo]) : window[lo];
+            }
+        }
+        return missing;
+    }
+
+    /**
+     @author: agent
+     @param what: name of the case, printed with the result
+     @param got: one Rolling result matrix per entry of all_stats
+     @param windowOf: windowOf(i, k) gives the [first, last] observations of
+     window k at row i, or nullopt if that row must be NaN
+     @param tol: largest allowed |got - brute| / (1 + |brute|)
+     */
+    template<typename T, typename WindowOf>
+    void check(const std::string& what,
+               const Vec<T>& data,
+               const std::vector<Mat<result_t<T>>>& got,
+               size_t nw,
+               double q,
+               WindowOf windowOf,
+               double tol)
+    {
+        for(size_t s = 0; s < all_stats.size(); s++){
+            double worst = 0;
+            bool nanMismatch = false;
+            for(Eigen::Index i = 0; i < data.size(); i++){
+                for(size_t k = 0; k < nw; k++){
+                    double expect = missing;
+                    if(auto range = windowOf(i, k)){
+                        std::vector<double> window;
+                        for(auto j = range->first; j <= range->second; j++){
+                            window.push_back(static_cast<double>(data[j]));
+                        }
+                        expect = brute(static_cast<double>(data[i]), window, all_stats[s], q);
+                    }
+                    double actual = static_cast<double>(got[s](i, k));
+                    if(std::isnan(expect) or std::isnan(actual)){
+                        nanMismatch |= (std::isnan(expect) != std::isnan(actual));
+                        continue;
+                    }
+                    worst = std::max(worst, std::abs(actual - expect) / (1 + std::abs(expect)));
+                }
+            }
+            bool ok = not nanMismatch and worst <= tol;
+            std::printf("%s %-28s %-9s max rel err %.3e (tol %.0e)%s\n",
+                        ok ? "PASS" : "FAIL", what.c_str(), stat_names[s], worst, tol,
+                        nanMismatch ? " NaN mismatch" : "");
+            failures += not ok;
+        }
+    }
+
+    //runs count-based windows over data and checks them against brute force
+    template<typename T>
+    void check_counts(const std::string& what,
+                      const Vec<T>& data,
+                      const std::vector<size_t>& windows,
+                      double q,
+                      double tol)
+    {
+        auto got = Rolling<T>(data, windows).compute(all_stats, q);
+        auto windowOf = [&](Eigen::Index i, size_t k) -> std::optional<std::pair<Eigen::Index, Eigen::Index>> {
+            auto w = static_cast<Eigen::Index>(windows[k]);
+            if(i + 1 < w){
+                return std::nullopt;
+            }
+            return std::make_pair(i + 1 - w, i);
+        };
+        check(what, data, got, windows.size(), q, windowOf, tol);
+    }
+}
+
+int main()
+{
+    std::mt19937 gen(20261019);
+    std::normal_distribution<double> eps(0, 1);
+    const std::vector<size_t> windows = {1, 2, 5, 20, 64};
+
+    //level shift far from the first observation, and back again
+    {
+        const Eigen::Index n = 600;
+        Vec<double> x(n);
+        x[0] = 0;
+        for(Eigen::Index t = 1; t < n; t++){
+            x[t] = (t < 400 ? 1e9 : -3.0) + eps(gen);
+        }
+        check_counts("level shift", x, windows, 0.5, 1e-10);
+    }
+
+    //a single huge spike in unit noise
+    {
+        const Eigen::Index n = 500;
+        Vec<double> x(n);
+        for(Eigen::Index t = 0; t < n; t++){
+            x[t] = eps(gen);
+        }
+        x[100] = 1e8;
+        check_counts("spike", x, windows, 0.3, 1e-10);
+    }
+
+    //random walk with NaN and inf observations, including a run of NaNs
+    {
+        const Eigen::Index n = 800;
+        Vec<double> x(n);
+        double w = 50;
+        for(Eigen::Index t = 0; t < n; t++){
+            w += eps(gen);
+            x[t] = w;
+        }
+        for(Eigen::Index t = 3; t < n; t += 17){
+            x[t] = missing;
+        }
+        x[40] = std::numeric_limits<double>::infinity();
+        x[41] = -std::numeric_limits<double>::infinity();
+        for(Eigen::Index t = 300; t < 330; t++){
+            x[t] = missing;
+        }
+        check_counts("non-finite", x, windows, 0.75, 1e-10);
+    }
+
+    //float storage, accumulated in double
+    {
+        const Eigen::Index n = 500;
+        Vec<float> x(n);
+        for(Eigen::Index t = 0; t < n; t++){
+            x[t] = static_cast<float>(100 + 5 * eps(gen));
+        }
+        x[250] = 1e6f;
+        check_counts("float spike", x, windows, 0.5, 1e-5);
+    }
+
+    //time-based windows over irregular, repeated dates with a level shift and NaNs
+    {
+        typedef boost::gregorian::date date;
+        typedef boost::gregorian::date_duration days;
+        const Eigen::Index n = 700;
+        Vec<double> x(n);
+        std::vector<date> times;
+        date d(2020, 1, 1);
+        std::uniform_int_distribution<int> gap(0, 3);
+        for(Eigen::Index t = 0; t < n; t++){
+            d += days(gap(gen));
+            times.push_back(d);
+            x[t] = (t > 350 ? 1e7 : 0) + eps(gen);
+        }
+        for(Eigen::Index t = 5; t < n; t += 23){
+            x[t] = missing;
+        }
+        x[500] = 1e12;
+        const std::vector<days> spans = {days(1), days(4), days(30)};
+        auto got = Rolling<double>(x, times, spans).compute(all_stats, 0.5);
+        auto windowOf = [&](Eigen::Index i, size_t k) -> std::optional<std::pair<Eigen::Index, Eigen::Index>> {
+            Eigen::Index first = i;
+            while(first > 0 and times[first - 1] > times[i] - spans[k]){
+                first--;
+            }
+            return std::make_pair(first, i);
+        };
+        check("spans", x, got, spans.size(), 0.5, windowOf, 1e-10);
+    }
+
+    //the ts entry points give the same results as the Vec-based API
+    {
+        Vec<double> x(300);
+        for(Eigen::Index t = 0; t < x.size(); t++){
+            x[t] = 1e6 + eps(gen);
+        }
+        ts<double> series(x);
+        //both paths run the same code, so results match exactly, warm-up NaNs included
+        auto same_as = [](const auto& a, const auto& b){
+            return a.rows() == b.rows() and a.cols() == b.cols() and
+                   ((a.array() == b.array()) or (a.array().isNaN() and b.array().isNaN())).all();
+        };
+        bool same = same_as(series.rolling(20).var(), Rolling<double>(x, {20}).var()) and
+                    same_as(series.rolling(std::vector<size_t>{3, 9}).max(),
+                            Rolling<double>(x, {3, 9}).max()) and
+                    same_as(series.ewm(0.1).mean(), EWM<double>(x, {0.1}).mean());
+        bool threw = false;
+        try {
+            series.rolling(boost::gregorian::date_duration(5));
+        } catch(TimeSeries::TSError e) {
+            threw = (e == TimeSeries::MissingTimeLabelsError);
+        }
+        bool ok = same and threw;
+        std::printf("%s %-38s\n", ok ? "PASS" : "FAIL", "ts::rolling/ewm entry points");
+        failures += not ok;
+    }
+
+    std::printf("%d failure(s)\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,255 @@
+/**
+ @author: agent
+ @brief: checks the work-stealing Scheduler: parallel_for coverage when
+ several outside threads use the pool at once, nested parallel_for with
+ and without set_nested, exception propagation through wait,
+ set_num_threads, set_pinning and first_touch_copy. The pool is started
+ with four workers whatever the machine, so stealing and nesting are
+ exercised even on one CPU. Build and run with `make check` in this
+ directory.
+ */
+#include "../include/scheduler.hpp"
+#include "../include/ts_error.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+    #include <sched.h>
+#endif
+
+using namespace TimeSeries;
+
+namespace
+{
+    int failures = 0;
+
+    void report(const std::string& what, bool ok)
+    {
+        std::printf("%s %s\n", ok ? "PASS" : "FAIL", what.c_str());
+        failures += not ok;
+    }
+
+    //true if parallel_for over [0, n) in chunks of grain visits every index exactly once
+    bool covers(size_t n, size_t grain)
+    {
+        std::vector<std::atomic<int>> hits(n);
+        Scheduler::instance().parallel_for(0, n, grain, [&](size_t b, size_t e){
+            for(size_t i = b; i < e; i++){
+                hits[i]++;
+            }
+        });
+        for(auto& h : hits){
+            if(h != 1){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //largest number of CPUs any worker may run on, checked from a task on each worker
+    int widest_worker_affinity()
+    {
+        std::atomic<int> widest {0};
+    #ifdef __linux__
+        auto& pool = Scheduler::instance();
+        TaskGroup group;
+        for(size_t w = 0; w < pool.num_threads(); w++){
+            pool.run(group, [&widest]{
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                sched_getaffinity(0, sizeof(set), &set);
+                int n = CPU_COUNT(&set);
+                int seen = widest;
+                while(n > seen and not widest.compare_exchange_weak(seen, n)){}
+            }, w);
+        }
+        pool.wait(group);
+    #endif
+        return widest;
+    }
+}
+
+int main()
+{
+    //read once, when the pool starts
+    setenv("TS_NUM_THREADS", "4", 1);
+    auto& pool = Scheduler::instance();
+    report("TS_NUM_THREADS sizes the pool", pool.num_threads() == 4);
+
+    //every index is visited exactly once, including ragged last chunks and grain > range
+    report("parallel_for coverage",
+           covers(100000, 1000) and covers(1001, 10) and covers(7, 100) and covers(1, 1));
+
+    //several outside threads share the pool at once
+    {
+        std::vector<std::thread> callers;
+        std::atomic<bool> ok {true};
+        for(int k = 0; k < 4; k++){
+            callers.emplace_back([&ok]{
+                for(int rep = 0; rep < 50; rep++){
+                    if(not covers(10000, 97)){
+                        ok = false;
+                    }
+                }
+            });
+        }
+        for(auto& t : callers){
+            t.join();
+        }
+        report("parallel_for from concurrent outside threads", ok);
+    }
+
+    //without set_nested an inner parallel_for runs serially on the task's own thread
+    {
+        std::atomic<bool> serial {true};
+        std::atomic<long> inner {0};
+        pool.parallel_for(0, 64, 4, [&](size_t, size_t){
+            auto outer = Scheduler::worker_id();
+            pool.parallel_for(0, 8, 1, [&](size_t b, size_t e){
+                if(Scheduler::worker_id() != outer){
+                    serial = false;
+                }
+                inner += e - b;
+            });
+        });
+        report("nested parallel_for runs inline by default", serial and inner == 16 * 8);
+    }
+
+    //with set_nested inner loops fan out, from several outside threads at once
+    {
+        pool.set_nested(true);
+        std::vector<std::thread> callers;
+        std::atomic<long> total {0};
+        for(int k = 0; k < 4; k++){
+            callers.emplace_back([&]{
+                for(int rep = 0; rep < 50; rep++){
+                    pool.parallel_for(0, 64, 4, [&](size_t, size_t){
+                        pool.parallel_for(0, 8, 1, [&](size_t b, size_t e){
+                            total += e - b;
+                        });
+                    });
+                }
+            });
+        }
+        for(auto& t : callers){
+            t.join();
+        }
+        pool.set_nested(false);
+        report("nested parallel_for with set_nested", total == 4L * 50 * 16 * 8);
+    }
+
+    //the first exception of a group is rethrown by wait, and the pool stays usable
+    {
+        bool caught = false;
+        try {
+            pool.parallel_for(0, 100, 1, [](size_t b, size_t){
+                if(b == 50){
+                    throw std::runtime_error("chunk 50");
+                }
+            });
+        } catch(const std::runtime_error& e) {
+            caught = std::string(e.what()) == "chunk 50";
+        }
+
+        bool nestedCaught = false;
+        pool.set_nested(true);
+        try {
+            pool.parallel_for(0, 8, 1, [&](size_t, size_t){
+                pool.parallel_for(0, 8, 1, [](size_t b, size_t){
+                    if(b == 3){
+                        throw TimeSeries::InvalidParameterError;
+                    }
+                });
+            });
+        } catch(TimeSeries::TSError e) {
+            nestedCaught = (e == TimeSeries::InvalidParameterError);
+        }
+        pool.set_nested(false);
+
+        TaskGroup group;
+        std::atomic<int> ran {0};
+        for(int i = 0; i < 20; i++){
+            pool.run(group, [&ran, i]{
+                ran++;
+                if(i % 5 == 0){
+                    throw std::logic_error("task");
+                }
+            });
+        }
+        bool groupCaught = false;
+        try {
+            pool.wait(group);
+        } catch(const std::logic_error&) {
+            groupCaught = true;
+        }
+        report("exceptions propagate through wait",
+               caught and nestedCaught and groupCaught and ran == 20 and covers(1000, 10));
+    }
+
+    //set_num_threads restarts the pool, and is refused with 0 or from inside a task
+    {
+        pool.set_num_threads(3);
+        bool resized = pool.num_threads() == 3 and covers(5000, 7);
+        pool.set_num_threads(4);
+        resized = resized and pool.num_threads() == 4 and covers(5000, 7);
+
+        bool zeroRefused = false;
+        try {
+            pool.set_num_threads(0);
+        } catch(TimeSeries::TSError e) {
+            zeroRefused = (e == TimeSeries::InvalidParameterError);
+        }
+        bool insideRefused = false;
+        try {
+            pool.parallel_for(0, 2, 1, [&](size_t, size_t){
+                pool.set_num_threads(2);
+            });
+        } catch(TimeSeries::TSError e) {
+            insideRefused = (e == TimeSeries::InvalidParameterError);
+        }
+        report("set_num_threads",
+               resized and zeroRefused and insideRefused and pool.num_threads() == 4);
+    }
+
+    //pinned workers each run on one CPU; unpinned ones keep the whole affinity mask
+    {
+        bool ok = true;
+    #ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        sched_getaffinity(0, sizeof(set), &set);
+        const int allowed = CPU_COUNT(&set);
+        pool.set_pinning(true);
+        ok = pool.pinned() and widest_worker_affinity() == 1;
+        pool.set_pinning(false);
+        ok = ok and not pool.pinned() and widest_worker_affinity() == allowed and
+             pool.num_threads() == 4 and covers(5000, 7);
+        pool.set_pinning(true);
+    #endif
+        report("set_pinning", ok);
+    }
+
+    //first_touch_copy returns an exact copy for any size and grain
+    {
+        bool ok = true;
+        for(Eigen::Index n : {0, 1, 999, 100000}){
+            for(size_t grain : {1, 64, 1000, 1000000}){
+                if(n > 2000 and grain == 1){
+                    continue;
+                }
+                Vec<double> xd = Vec<double>::LinSpaced(n, -1, 1);
+                Vec<float> xf = xd.cast<float>();
+                ok = ok and first_touch_copy(xd, grain) == xd and first_touch_copy(xf, grain) == xf;
+            }
+        }
+        report("first_touch_copy", ok);
+    }
+
+    std::printf("%d failure(s)\n", failures);
+    return failures != 0;
+}